@@ -0,0 +1,183 @@
+/** @file BinarySearchMap.h
+ @brief Contains the class declarations and definitions for a BinarySearchMap templated class, and the MapKeyCompare comparator it sorts with.
+
+ The BinarySearchMap stores key/value pairs in a BinarySearchTree of std::pair<const K,V>, ordered by the key only. It reuses the tree's
+ nodes and TreeIterators, so iterating the map gives pairs in key order, and it->second can be changed through an iterator while the
+ key stays const. operator[], try_emplace and insert_or_assign find the key with a single descent and either update the value in place
+ or link a new node where the descent ended, so changing a value never costs an erase plus an insert.
+ */
+
+#ifndef BinarySearchMap_h
+#define BinarySearchMap_h
+#include "BinarySearchTree.h"
+#include <functional>
+#include <tuple>
+#include <utility>
+
+/**@class MapKeyCompare
+	@brief Class to order the key/value pairs of a BinarySearchMap by key, using the CMP comparator on the keys.
+ It also compares a bare key against a pair, so the map can search by key without building a pair.
+ */
+template <typename K,typename V,typename CMP>
+class MapKeyCompare
+{
+public:
+    //compare two pairs by key
+    bool operator()(const std::pair<const K,V>& a, const std::pair<const K,V>& b) const { return isless(a.first,b.first); }
+    //compare a key with a pair
+    bool operator()(const K& a, const std::pair<const K,V>& b) const { return isless(a,b.first); }
+    //compare a pair with a key
+    bool operator()(const std::pair<const K,V>& a, const K& b) const { return isless(a.first,b); }
+
+private:
+    //comparator for the keys
+    CMP isless;
+};
+
+
+template <typename K,typename V,typename CMP=std::less<K>>
+class BinarySearchMap
+{
+public:
+    typedef std::pair<const K,V> value_type;
+    typedef MapKeyCompare<K,V,CMP> compare_type;
+    typedef TreeIterator<value_type,compare_type> iterator;
+
+    //access the value of key, inserting a default constructed value if the key is missing
+    V& operator[](const K& key);
+    //construct a value from args only if key is missing
+    template <typename... Args>
+    std::pair<iterator,bool> try_emplace(const K& key, Args&&... args);
+    //insert the key with value, or overwrite the value of an existing key
+    template <typename M>
+    std::pair<iterator,bool> insert_or_assign(const K& key, M&& value);
+    //find key, returns end() if it is not in the map
+    iterator find(const K& key);
+    //remove key and its value
+    void erase(const K& key);
+    //access iterator to the smallest key and one after the largest key
+    iterator begin();
+    iterator end();
+
+private:
+    //tree holding the key/value pairs
+    BinarySearchTree<value_type,compare_type> tree;
+};
+
+
+/** Definition of the [] operator, that gives access to the value stored with a key. If the key is not in the map a default constructed value is inserted first.
+
+ @param key whose value you want
+ @return reference to the value stored with key
+ */
+template <typename K,typename V,typename CMP>
+V& BinarySearchMap<K,V,CMP>::operator[](const K& key)
+{
+    //try_emplace with no arguments default constructs the value when the key is missing
+    return try_emplace(key).first->second;
+}
+
+
+/** Definition of the try_emplace function, that searches for the key once and, if it is missing, links a new node built from the key and args
+ where the search ended. If the key is already in the map nothing is constructed and the value is left alone.
+
+ @param key you want to insert
+ @param args are the constructor arguments of the value
+ @return iterator to the pair with the key, and true if a new pair was inserted
+ */
+template <typename K,typename V,typename CMP>
+template <typename... Args>
+std::pair<typename BinarySearchMap<K,V,CMP>::iterator,bool> BinarySearchMap<K,V,CMP>::try_emplace(const K& key, Args&&... args)
+{
+    TreeNode<value_type,compare_type>* parent2;
+    bool as_left;
+    TreeNode<value_type,compare_type>* found = tree.find_position(key, parent2, as_left);
+    //if the key is already in the map, hand back its node
+    if (found != nullptr)
+        return std::make_pair(tree.iterator_at(found), false);
+
+    //build the pair in the new node and link it where the search ended
+    TreeNode<value_type,compare_type>* new_node = tree.make_node(std::piecewise_construct,
+                                                                 std::forward_as_tuple(key),
+                                                                 std::forward_as_tuple(std::forward<Args>(args)...));
+    tree.link_node(new_node, parent2, as_left);
+    return std::make_pair(tree.iterator_at(new_node), true);
+}
+
+
+/** Definition of the insert_or_assign function, that inserts a key with a value, or overwrites the value in place if the key is already in the map.
+
+ @param key you want to insert
+ @param value to store with the key
+ @return iterator to the pair with the key, and true if a new pair was inserted
+ */
+template <typename K,typename V,typename CMP>
+template <typename M>
+std::pair<typename BinarySearchMap<K,V,CMP>::iterator,bool> BinarySearchMap<K,V,CMP>::insert_or_assign(const K& key, M&& value)
+{
+    std::pair<iterator,bool> result = try_emplace(key, std::forward<M>(value));
+    //the key was already there, so update its value in place
+    if (!result.second)
+        result.first->second = std::forward<M>(value);
+    return result;
+}
+
+
+/** Definition of the find function, that searches the map for a key.
+
+ @param key you want to look up
+ @return iterator to the pair with the key, or end() if it is not in the map
+ */
+template <typename K,typename V,typename CMP>
+typename BinarySearchMap<K,V,CMP>::iterator BinarySearchMap<K,V,CMP>::find(const K& key)
+{
+    TreeNode<value_type,compare_type>* parent2;
+    bool as_left;
+    TreeNode<value_type,compare_type>* found = tree.find_position(key, parent2, as_left);
+    //not found means the end iterator
+    if (found == nullptr) return end();
+    return tree.iterator_at(found);
+}
+
+
+/** Definition of the erase function, that removes a key and its value from the map if it is there.
+
+ @param key you want to remove
+ */
+template <typename K,typename V,typename CMP>
+void BinarySearchMap<K,V,CMP>::erase(const K& key)
+{
+    TreeNode<value_type,compare_type>* parent2;
+    bool as_left;
+    TreeNode<value_type,compare_type>* found = tree.find_position(key, parent2, as_left);
+    //nothing to do if the key is not in the map
+    if (found == nullptr) return;
+    //relink the tree around the node and free it
+    tree.erase_node(found);
+    delete found;
+}
+
+
+/** Definition of the begin() function, returns an iterator to the pair with the smallest key
+
+ @return iterator to the smallest key of the map
+ */
+template <typename K,typename V,typename CMP>
+typename BinarySearchMap<K,V,CMP>::iterator BinarySearchMap<K,V,CMP>::begin()
+{
+    return tree.begin();
+}
+
+
+/** Definition of the end() function, returns an iterator to the position after the largest key
+
+ @return iterator to one after the largest key of the map
+ */
+template <typename K,typename V,typename CMP>
+typename BinarySearchMap<K,V,CMP>::iterator BinarySearchMap<K,V,CMP>::end()
+{
+    return tree.end();
+}
+
+
+#endif /* BinarySearchMap_h */
@@ -11,16 +11,90 @@
  AFTER the largest node in the tree, we call this node endNode and save it as a public variable of the tree.
 
  We create this endNode place saver so that we can still call -- on an iterator pointing to the node after the largest node. 
+ Since the endNode always hangs off the largest node, its parent is the largest node. The tree also keeps a beginNode pointer to the smallest
+ node, updated by every insert and erase, so begin(), smallest(), largest(), pop_min() and pop_max() never have to search the tree.
+
+ In lazy erase mode (see set_lazy_erase) erase only marks the node as a tombstone. Iterators, find and print skip tombstones, and once they make
+ up too much of the tree compact() rebuilds the remaining nodes into a balanced tree in one linear pass. Nodes freed by compaction are kept on
+ a spare list and reused by later inserts instead of allocating.
+
+ With a summary policy AUG (see TreeSummary.h) every node also keeps a summary of its subtree, so aggregate(lo, hi) combines a range in
+ O(height) steps instead of visiting every value.
+ print() and write_to format values into one large buffer and write it out in a few big blocks, as text, CSV or binary.
+ set_filter puts a Bloom filter in front of find and contains, so lookups of values that are not in the tree usually skip the search.
+ set_hash_index keeps a hash table from values to their nodes (see HashIndex.h), so find and contains answer exact matches without a search
+ while ordered operations still use the tree.
+ parallel_for_each, parallel_reduce and parallel_transform split the tree into in-order pieces and hand them to a group of threads.
+ set_capacity bounds the tree for offer(), which keeps the capacity largest values of a stream by reusing the smallest node for each value
+ it lets in, so a full tree never allocates.
  */
 
 #ifndef BinarySearchTree_h
 #define BinarySearchTree_h
 #include "TreeNode.h"
 #include "TreeIterator.h"
+#include "TreeHash.h"
+#include "BloomFilter.h"
+#include "HashIndex.h"
+#include "TreeWriter.h"
 #include <iostream>
 #include <functional>
+#include <utility>
+#include <stdexcept>
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include "TreeSummary.h"
+
+//hint the CPU to start loading a node we are about to visit, where the compiler supports it
+#if defined(__GNUC__) || defined(__clang__)
+#define BST_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define BST_PREFETCH(address) ((void)(address))
+#endif
+
+/**@struct TreeStats
+	@brief Counters a BinarySearchTree keeps about its contents and upkeep.
+ */
+struct TreeStats
+{
+    //number of values in the tree
+    std::size_t size;
+    //erased nodes still linked into the tree as tombstones
+    std::size_t tombstones;
+    //number of times compact() rebuilt the tree
+    std::size_t compactions;
+    //nodes taken from the spare list instead of allocated
+    std::size_t recycled_nodes;
+    //freed nodes waiting on the spare list
+    std::size_t spare_nodes;
+    //number of times a node was splayed to the root
+    std::size_t splays;
+    //single rotations done by splaying
+    std::size_t rotations;
+    //lookups the filter answered without searching the tree
+    std::size_t filter_negatives;
+    //lookups the filter passed on to the tree
+    std::size_t filter_positives;
+    //lookups the filter passed on for values that were not in the tree
+    std::size_t filter_false_positives;
+    //number of times the filter was refilled
+    std::size_t filter_rebuilds;
+    //lookups answered by the hash index
+    std::size_t index_lookups;
+    //offers turned away because they were not better than the smallest value
+    std::size_t rejected_offers;
+    //offers that took over the smallest node without moving it
+    std::size_t in_place_offers;
+};
 
-template <typename T,typename CMP= std::less<T>>
+template <typename T,typename CMP= std::less<T>,typename AUG=NoSummary>
 class BinarySearchTree
 {
 public:
@@ -32,78 +106,269 @@ public:
     BinarySearchTree(BinarySearchTree&& copy);
     //assignment operator
     BinarySearchTree& operator=(BinarySearchTree assign);
+    //exchange contents with another tree
+    void swap(BinarySearchTree& other);
     //insert element into tree
     void insert(T data);
+    //insert element starting the search from hint, returns an iterator to the element
+    TreeIterator<T,CMP,AUG> insert(TreeIterator<T,CMP,AUG> hint, T data);
     //remove element
     void erase(T data);
+    //find element, returns end() if it is not in the tree
+    TreeIterator<T,CMP,AUG> find(const T& data);
+    //check whether data is in the tree, without splaying
+    bool contains(const T& data);
+    //combine the summaries of the values in [lo, hi) in order
+    typename AUG::summary_type aggregate(const T& lo, const T& hi) const;
+    //find the first element not less than data, returns end() if there is none
+    TreeIterator<T,CMP,AUG> lower_bound(const T& data);
+    //find every key, results[i] is set to find(keys[i])
+    void find_many(const std::vector<T>& keys, std::vector<TreeIterator<T,CMP,AUG>>& results);
+    //lower_bound every key, results[i] is set to lower_bound(keys[i])
+    void lower_bound_many(const std::vector<T>& keys, std::vector<TreeIterator<T,CMP,AUG>>& results);
     //print all elements
     void print() const;
+    //write all elements in order to a stream
+    void write_to(std::ostream& os, OutputFormat format = OutputFormat::text) const;
+    //write all elements in order to an open file descriptor
+    void write_to(int fd, OutputFormat format = OutputFormat::text) const;
     //find the smallest T value in tree
     T smallest();
     //find the largest T value in tree
     T largest();
+    //remove and return the smallest T value in tree
+    T pop_min();
+    //remove and return the largest T value in tree
+    T pop_max();
     //access iterator to the smallest and largest values of tree
-    TreeIterator<T,CMP> begin();
-    TreeIterator<T,CMP> end();
+    TreeIterator<T,CMP,AUG> begin();
+    TreeIterator<T,CMP,AUG> end();
+    //number of values in the tree
+    std::size_t size() const;
+    //counters about the tree
+    const TreeStats& stats() const;
+    //make erase leave tombstones, compacting once they are more than max_tombstone_ratio of the nodes
+    void set_lazy_erase(bool lazy, double max_tombstone_ratio = 0.5);
+    //drop all tombstones and rebuild the tree into balanced shape
+    void compact();
+    //merge a sorted range of values into the tree and rebuild it into balanced shape
+    template <typename InputIt>
+    void merge_sorted(InputIt first, InputIt last);
+    //limit offer to keeping the capacity largest values, 0 for no limit
+    void set_capacity(std::size_t capacity);
+    //insert data if the tree has room or data is bigger than the smallest value, which it then replaces
+    bool offer(T data);
+    //keep a Bloom filter of the values so find and contains can skip the search for most missing values
+    void set_filter(bool enabled, double false_positive_rate = 0.01);
+    //keep a hash index from values to their nodes so find and contains take one probe
+    void set_hash_index(bool enabled);
+    //move a value to the root on every interval-th find or insert, 0 turns splaying off
+    void set_splay_interval(std::size_t interval);
+    //number of threads the parallel functions use, 0 for one per core
+    void set_parallel_threads(unsigned threads);
+    //call fn on every value, spread over several threads in no particular order
+    template <typename F>
+    void parallel_for_each(F fn);
+    //fold every value into identity with op on several threads, combining the partial results in order with op
+    template <typename R,typename Op>
+    R parallel_reduce(R identity, Op op);
+    //same as parallel_reduce, but partial results are combined with combine
+    template <typename R,typename Op,typename Combine>
+    R parallel_reduce(R identity, Op op, Combine combine);
+    //apply fn to every value on several threads, returning the results in order
+    template <typename F>
+    auto parallel_transform(F fn) -> std::vector<typename std::decay<decltype(fn(std::declval<T&>()))>::type>;
     //destructor
     ~BinarySearchTree();
     //helper for copy constructor
-    void copy_helper(TreeNode<T,CMP>* N);
+    void copy_helper(TreeNode<T,CMP,AUG>* N, TreeNode<T,CMP,AUG>* end);
     //helper for destructor
-    void destroy(TreeNode<T,CMP>* N);
+    void destroy(TreeNode<T,CMP,AUG>* N);
     //TreeNode pointer to one after the largest node the tree
-    TreeNode<T,CMP>* endNode;
+    TreeNode<T,CMP,AUG>* endNode;
 private:
+    //descend to key, returning its node or the parent and side a new node would be linked under
+    template <typename K>
+    TreeNode<T,CMP,AUG>* find_position(const K& key, TreeNode<T,CMP,AUG>*& parent2, bool& as_left) const;
+    //same as find_position, but descending from the subtree rooted at start
+    template <typename K>
+    TreeNode<T,CMP,AUG>* descend(TreeNode<T,CMP,AUG>* start, const K& key, TreeNode<T,CMP,AUG>*& parent2, bool& as_left) const;
+    //same as find_position, but first tries the neighbours of hint and the spot after the largest node
+    template <typename K>
+    TreeNode<T,CMP,AUG>* find_position(TreeNode<T,CMP,AUG>* hint, const K& key, TreeNode<T,CMP,AUG>*& parent2, bool& as_left);
+    //format every element into out
+    void write_values(OutputBuffer& out, OutputFormat format) const;
+    //walk down for a group of keys at once, interleaving their descents
+    void descend_many(const std::vector<T>& keys, std::vector<TreeIterator<T,CMP,AUG>>& results, bool lower);
+    //link a new node under the position returned by find_position
+    void link_node(TreeNode<T,CMP,AUG>* new_node, TreeNode<T,CMP,AUG>* parent2, bool as_left);
+    //unlink a node from the tree without deleting it
+    void erase_node(TreeNode<T,CMP,AUG>* N);
+    //put the subtree new_child where the subtree N used to be
+    void replace_child(TreeNode<T,CMP,AUG>* N, TreeNode<T,CMP,AUG>* new_child);
+    //create an iterator pointing at a node
+    TreeIterator<T,CMP,AUG> iterator_at(TreeNode<T,CMP,AUG>* N);
+    //put a new node with the same key in the place of a tombstone
+    void revive(TreeNode<T,CMP,AUG>* tombstone, TreeNode<T,CMP,AUG>* fresh);
+    //relink nodes, which are in order, into a balanced tree
+    void rebuild(std::vector<TreeNode<T,CMP,AUG>*>& nodes);
+    //build a balanced subtree out of nodes[lo,hi), which are in order
+    TreeNode<T,CMP,AUG>* build_balanced(std::vector<TreeNode<T,CMP,AUG>*>& nodes, std::size_t lo, std::size_t hi, TreeNode<T,CMP,AUG>* parent2);
+    //split the tree into in-order pieces for the parallel functions, each a single node or a whole subtree
+    void split_tasks(std::vector<std::pair<TreeNode<T,CMP,AUG>*,bool>>& tasks) const;
+    //call fn on every live value of the subtree rooted at N, in order
+    template <typename F>
+    void visit_subtree(TreeNode<T,CMP,AUG>* N, F& fn);
+    //run work(i) for every task index i on the parallel threads
+    template <typename Work>
+    void run_tasks(std::size_t count, Work work) const;
+    //true if the filter rules data out, counting the answer
+    bool filter_rejects(const T& data);
+    //note that a value left the tree, refilling the filter once too many are stale
+    void filter_remove();
+    //refill the filter with the values in the tree, sized for twice as many
+    void rebuild_filter();
+    //fill the hash index with the nodes in the tree
+    void rebuild_index();
+    //hashes a value for the filter and the hash index, instantiated by set_filter and set_hash_index only
+    static std::size_t value_hash(const T& data);
+    //summary of the subtree rooted at N, the identity for an empty subtree or the endNode
+    typename AUG::summary_type subtree_summary(const TreeNode<T,CMP,AUG>* N) const;
+    //summary of N's own value, the identity for a tombstone
+    typename AUG::summary_type value_summary(const TreeNode<T,CMP,AUG>* N) const;
+    //recompute the summary of N from its children
+    void update_summary(TreeNode<T,CMP,AUG>* N);
+    //recompute the summaries of N and all its ancestors
+    void update_path(TreeNode<T,CMP,AUG>* N);
+    //count an access to N and splay it if it is due
+    void touch(TreeNode<T,CMP,AUG>* N);
+    //rotate N up to the root
+    void splay(TreeNode<T,CMP,AUG>* N);
+    //rotate N above its parent
+    void rotate_up(TreeNode<T,CMP,AUG>* N);
+    //create a node, reusing a spare one if there is any
+    template <typename... Args>
+    TreeNode<T,CMP,AUG>* make_node(Args&&... args);
+    //destroy a node and keep its memory on the spare list
+    void free_node(TreeNode<T,CMP,AUG>* N);
     //TreeNode pointer to the root of the tree
-    TreeNode<T,CMP>* root;
-   
+    TreeNode<T,CMP,AUG>* root;
+    //TreeNode pointer to the smallest node of the tree
+    TreeNode<T,CMP,AUG>* beginNode;
+    //to compare data based on specified comparator
+    CMP isless;
+    //true if erase leaves tombstones
+    bool lazyErase;
+    //fraction of tombstones at which erase compacts the tree
+    double maxTombstoneRatio;
+    //counters reported by stats()
+    TreeStats treeStats;
+    //memory of freed nodes, each holding a pointer to the next one
+    void* spareNodes;
+    //threads used by the parallel functions, 0 for one per core
+    unsigned parallelThreads;
+    //splay every splayInterval-th accessed node, 0 for never
+    std::size_t splayInterval;
+    //accesses since the last splay
+    std::size_t accessCount;
+    //filter of the values in the tree
+    BlockedBloomFilter filter;
+    //hash function of the filter, nullptr when there is no filter
+    std::size_t (*filterHash)(const T&);
+    //false positive rate the filter is sized for
+    double filterRate;
+    //values removed since the filter was last filled, whose bits are still set
+    std::size_t staleKeys;
+    //hash table from values to their nodes, off unless set_hash_index turned it on
+    HashIndex<T,CMP,AUG> index;
+    //most values offer keeps, 0 for no limit
+    std::size_t maxSize;
+    //the map variant reuses the node primitives above
+    template <typename K,typename V,typename C> friend class BinarySearchMap;
 
 };
 
 /** Definition of standard constructor for the binary search tree that essentially just sets the root to nullptr
 
  */
-template <typename T,typename CMP>
-BinarySearchTree<T,CMP>::BinarySearchTree()
+template <typename T,typename CMP,typename AUG>
+BinarySearchTree<T,CMP,AUG>::BinarySearchTree()
 {
     //set root to null
     root = nullptr;
+    beginNode = nullptr;
     //set our "endNode" to null
     endNode=nullptr;
+    //erase removes nodes right away unless lazy erase is turned on
+    lazyErase = false;
+    maxTombstoneRatio = 0.5;
+    treeStats = TreeStats();
+    spareNodes = nullptr;
+    parallelThreads = 0;
+    splayInterval = 0;
+    accessCount = 0;
+    filterHash = nullptr;
+    filterRate = 0.01;
+    staleKeys = 0;
+    maxSize = 0;
    
 }
 
 /** Definition of deep copy constructor for binary search tree, uses the copy_helper function(defined next) in order to successfully copy each element of the binary search tree.
+ The copy is balanced, whatever shape the tree being copied has.
  
  @param binary search tree that you want to make a copy of (L VALUE)
  */
-template <typename T,typename CMP>
-BinarySearchTree<T,CMP>::BinarySearchTree(const BinarySearchTree<T,CMP> &copy)
+template <typename T,typename CMP,typename AUG>
+BinarySearchTree<T,CMP,AUG>::BinarySearchTree(const BinarySearchTree<T,CMP,AUG> &copy) : BinarySearchTree()
 {
-    //set initial root to null just in case the tree you want to copy is empty
-    root=nullptr;
+    //keep the same erase mode as the tree we copy
+    lazyErase=copy.lazyErase;
+    maxTombstoneRatio=copy.maxTombstoneRatio;
+    parallelThreads=copy.parallelThreads;
+    splayInterval=copy.splayInterval;
+    maxSize=copy.maxSize;
     //give the root of the tree you want to copy to the copy_helper
-    copy_helper(copy.root);
+    copy_helper(copy.root,copy.endNode);
+    //fill the filter once at the end instead of growing it while copying
+    if (copy.filterHash != nullptr)
+    {
+        filterHash = copy.filterHash;
+        filterRate = copy.filterRate;
+        rebuild_filter();
+    }
+    if (copy.index.enabled())
+        set_hash_index(true);
     std::cout<<"Copy made"<<std::endl;
 }
 
 
-/** The Copy_helper function inserts the current node into the new tree, and then recursively calls itself on the children of the current node so that we efficiently deep copy the entire tree.
- @param root of subtree you want to copy
+/** The Copy_helper function walks the tree being copied in order, creates a new node for every value (new heap memory so this is a deep copy),
+ and links the new nodes into a balanced tree in one pass. The walk follows parent links instead of recursing, so a long spine (which
+ sorted inserts build) can't overflow the stack. Tombstones are not copied.
+ @param root of the tree you want to copy
+ @param endNode of the tree being copied, which ends the walk
  */
-template <typename T,typename CMP>
-void BinarySearchTree<T,CMP>::copy_helper(TreeNode<T,CMP>* N)
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::copy_helper(TreeNode<T,CMP,AUG>* N, TreeNode<T,CMP,AUG>* end)
 
 {
-    //as long as our subtree is not empty
-    if(N!=nullptr)
+    //an empty tree has nothing to copy
+    if (N == nullptr || N == end) return;
+    TreeNode<T,CMP,AUG>* first = N;
+    while (first->left != nullptr)
+        first = first->left;
+    std::vector<TreeNode<T,CMP,AUG>*> nodes;
+    for (TreeNode<T,CMP,AUG>* M = first; M != nullptr && M != end; M = TreeIterator<T,CMP,AUG>::next_node(M))
     {
-        //insert the current node (new heap memory so this is a deep copy)
-        insert(N->data);
-        //recursively call copy on the left and right subtree until they are empty
-        copy_helper(N->left);
-        copy_helper(N->right);
+        if (!M->erased)
+            nodes.push_back(make_node(M->data));
     }
+    if (nodes.empty()) return;
+    treeStats.size = nodes.size();
+    if (endNode == nullptr)
+        endNode = new TreeNode<T,CMP,AUG>();
+    rebuild(nodes);
 }
 
 
@@ -111,13 +376,11 @@ void BinarySearchTree<T,CMP>::copy_helper(TreeNode<T,CMP>* N)
  
  @param binary search tree that you want to make a copy of (R VALUE)
  */
-template <typename T,typename CMP>
-BinarySearchTree<T,CMP>::BinarySearchTree(BinarySearchTree&& copy)
+template <typename T,typename CMP,typename AUG>
+BinarySearchTree<T,CMP,AUG>::BinarySearchTree(BinarySearchTree&& copy) : BinarySearchTree()
 {
-    //steal root
-    this->root=copy.root;
-    //set parameters root to null
-    copy.root=nullptr;
+    //steal everything, leaving the parameter empty
+    swap(copy);
     std::cout<<"Move performed"<<std::endl;
 
 }
@@ -126,278 +389,1720 @@ BinarySearchTree<T,CMP>::BinarySearchTree(BinarySearchTree&& copy)
  @param binary search tree that you want to assign
  @return reference to a deep copy of the parameter
  */
-template <typename T,typename CMP>
-BinarySearchTree<T,CMP>& BinarySearchTree<T,CMP>::operator=(BinarySearchTree assign)
+template <typename T,typename CMP,typename AUG>
+BinarySearchTree<T,CMP,AUG>& BinarySearchTree<T,CMP,AUG>::operator=(BinarySearchTree assign)
 {
    //shallow swap
-    std::swap(this->root, assign.root);
+    swap(assign);
     return *this;
 }
 
+/** Definition of the swap function, that exchanges the nodes and settings of two trees without copying any nodes.
+ 
+ @param other is the tree to swap with
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::swap(BinarySearchTree& other)
+{
+    std::swap(root, other.root);
+    std::swap(beginNode, other.beginNode);
+    std::swap(endNode, other.endNode);
+    std::swap(isless, other.isless);
+    std::swap(lazyErase, other.lazyErase);
+    std::swap(maxTombstoneRatio, other.maxTombstoneRatio);
+    std::swap(treeStats, other.treeStats);
+    std::swap(spareNodes, other.spareNodes);
+    std::swap(parallelThreads, other.parallelThreads);
+    std::swap(splayInterval, other.splayInterval);
+    std::swap(accessCount, other.accessCount);
+    std::swap(filter, other.filter);
+    std::swap(filterHash, other.filterHash);
+    std::swap(filterRate, other.filterRate);
+    std::swap(staleKeys, other.staleKeys);
+    std::swap(index, other.index);
+    std::swap(maxSize, other.maxSize);
+}
+
 /** Definition of the Binary Search tree destructor, necessary because the destructor manages memory located on the heap.
  we use the helper function destroy, to safely delete the memory (defined next)
  */
-template <typename T,typename CMP>
-BinarySearchTree<T,CMP>::~BinarySearchTree()
+template <typename T,typename CMP,typename AUG>
+BinarySearchTree<T,CMP,AUG>::~BinarySearchTree()
 {
     //use helper function to safely delete memory
     destroy(root);
+    //the endNode is skipped by destroy, since it outlives an emptied tree
+    delete endNode;
+    //give back the memory of spare nodes
+    while (spareNodes != nullptr)
+    {
+        void* mem = spareNodes;
+        spareNodes = *static_cast<void**>(mem);
+        ::operator delete(mem);
+    }
 }
 
 
 
 
-/** Definition of the destroy function, which takes in a node and recursively calls destroy on the left subtree, and right subtree, and then deletes the node itself. This function helps us safely delete all heap memory of the binary search tree.
+/** Definition of the destroy function, which deletes every node of the subtree rooted at N. This function helps us safely delete all heap memory
+ of the binary search tree. It walks down to a node without children, unhooking each child it goes into so the node is a leaf once the walk
+ comes back up through its parent link, and deletes it. This takes no stack, so it is safe on a spine of any length.
+ The endNode is left alone, the destructor deletes it separately.
  */
-template <typename T,typename CMP>
-void BinarySearchTree<T,CMP>:: destroy(TreeNode<T,CMP> *N)
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>:: destroy(TreeNode<T,CMP,AUG> *N)
 {
-    //if the node exists
-    if(N!=nullptr)
+    TreeNode<T,CMP,AUG>* current = N;
+    while (current != nullptr && current != endNode)
     {
-        //destroy left subtree
-        destroy(N->left);
-        N->left=nullptr;
-        //destroy right subtree
-        destroy(N->right);
-        N->right=nullptr;
-        //delete the node
-        delete N;
+        //go into the left subtree first, then the right one
+        if (current->left != nullptr)
+        {
+            TreeNode<T,CMP,AUG>* child = current->left;
+            current->left = nullptr;
+            current = child;
+        }
+        else if (current->right != nullptr && current->right != endNode)
+        {
+            TreeNode<T,CMP,AUG>* child = current->right;
+            current->right = nullptr;
+            current = child;
+        }
+        else
+        {
+            //both subtrees are gone, delete the node and go back up
+            TreeNode<T,CMP,AUG>* parent2 = current->parent;
+            bool last = current == N;
+            delete current;
+            current = last ? nullptr : parent2;
+        }
     }
 }
 
 
-/** Definition of the print function, which calls print_nodes on the root of the tree in order to print out all the elements of the tree in order.
+/** Definition of the print function, which prints all the elements of the tree in order, one per line, to std::cout. It formats like write_to,
+ but the buffer is sized for about 16 bytes a value instead of the full megabyte, since print is mostly called on small trees. Longer
+ values only mean more flushes.
  */
-template <typename T,typename CMP>
-void BinarySearchTree<T,CMP>::print() const
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::print() const
 {
-    //if the tree is not empty, call the TreeNode's print function
-    if (root != endNode)
-        root->print_nodes();
+    OutputBuffer out(std::cout, std::min<std::size_t>(std::size_t(1) << 20, 16 * (treeStats.size + 1)));
+    write_values(out, OutputFormat::text);
+    out.flush();
 }
 
+/** Definition of the write_to function for streams, that formats the values into a large buffer and writes it to the stream in big blocks.
+ 
+ @param os is the stream to write to
+ @param format is text (one value per line, like print), csv (one row per value) or binary (packed values)
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::write_to(std::ostream& os, OutputFormat format) const
+{
+    OutputBuffer out(os);
+    write_values(out, format);
+    out.flush();
+}
 
-/** Definition of the insert function that essentially creates a new TreeNode with the desired integer value, then adds it to the tree.
- @param integer value of the node you want to insert into the tree
+/** Definition of the write_to function for file descriptors, that writes the buffer with write() calls, skipping the stream layer entirely.
  
+ @param fd is an open file descriptor, which is left open
+ @param format is text (one value per line, like print), csv (one row per value) or binary (packed values)
+ @throws std::system_error if a write fails
  */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::write_to(int fd, OutputFormat format) const
+{
+    OutputBuffer out(fd);
+    write_values(out, format);
+    out.flush();
+}
 
-template <typename T,typename CMP>
-void BinarySearchTree<T,CMP>::insert(T data)
+/** Definition of the write_values function, that walks the tree in order without recursion and formats each value that is not a tombstone
+ with ValueWriter.
+ 
+ @param out is the buffer to write to
+ @param format is the layout to write values in
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::write_values(OutputBuffer& out, OutputFormat format) const
+{
+    for (TreeNode<T,CMP,AUG>* N = beginNode; N != nullptr && N != endNode; N = TreeIterator<T,CMP,AUG>::next_node(N))
+    {
+        if (!N->erased)
+            ValueWriter<T>::write(out, N->data, format);
+    }
+}
+
+
+/** Definition of the insert function that essentially creates a new TreeNode with the desired value, then adds it to the tree.
+ Values that are already in the tree are ignored. A value larger than everything in the tree is appended after the largest node
+ without walking down from the root.
+ @param value of the node you want to insert into the tree
+ 
+ */
+
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::insert(T data)
+{
+    //the end() hint checks for an append before searching from the root
+    insert(end(), std::move(data));
+}
+
+/** Definition of the hinted insert function. If the value belongs right next to hint (or after the largest node) it is linked there in
+ amortised O(1), otherwise the search starts from the root like a plain insert. Inserting a sorted stream with the previous result as the
+ hint, or an increasing stream with any hint, never walks down the tree.
+ @param hint is an iterator near where the value belongs
+ @param value of the node you want to insert into the tree
+ @return TreeIterator to the inserted value, or to the equal value already in the tree
+ 
+ */
+
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> BinarySearchTree<T,CMP,AUG>::insert(TreeIterator<T,CMP,AUG> hint, T data)
 {
-    //create new TreeNode pointer
-    TreeNode<T,CMP>* new_node = new TreeNode<T,CMP>(*this);
-    //set its data value
-    new_node->data = data;
-    //set left and right pointers to nullptr
-    new_node->left = nullptr;
-    new_node->right = nullptr;
+    TreeNode<T,CMP,AUG>* parent2;
+    bool as_left;
+    TreeNode<T,CMP,AUG>* found = find_position(hint.node, data, parent2, as_left);
+    if (found != nullptr)
+    {
+        //if the value is already in the tree there is nothing to do
+        if (!found->erased)
+        {
+            touch(found);
+            return iterator_at(found);
+        }
+        //if it is a tombstone, a new node takes its place
+        TreeNode<T,CMP,AUG>* fresh = make_node(std::move(data));
+        revive(found, fresh);
+        touch(fresh);
+        return iterator_at(fresh);
+    }
+    //otherwise create the new TreeNode and link it where the search ended
+    TreeNode<T,CMP,AUG>* new_node = make_node(std::move(data));
+    link_node(new_node, parent2, as_left);
+    touch(new_node);
+    return iterator_at(new_node);
+}
+
+/** Definition of the erase function, that first tries to find the inputed value in the tree, and if found, removes it from the tree and relinks the tree safely.
+ In lazy erase mode the node is only marked as a tombstone, and the tree is compacted once there are too many tombstones.
+ 
+ @param value of the node you want to remove from the tree
+ 
+ */
+
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::erase(T data)
+{
+    // Find node to be removed
+    TreeNode<T,CMP,AUG>* parent2;
+    bool as_left;
+    TreeNode<T,CMP,AUG>* to_be_removed = find_position(data, parent2, as_left);
     
-    //if the tree is empty
+    //if we could not find the value, exit the function
+    if (to_be_removed == nullptr) return;
+    
+    if (lazyErase)
+    {
+        //mark the node, unless it already is a tombstone
+        if (to_be_removed->erased) return;
+        to_be_removed->erased = true;
+        --treeStats.size;
+        ++treeStats.tombstones;
+        update_path(to_be_removed);
+        filter_remove();
+        if (index.enabled())
+            index.erase(to_be_removed);
+        //rebuild once tombstones take up too much of the tree
+        if (treeStats.tombstones > maxTombstoneRatio * (treeStats.size + treeStats.tombstones))
+            compact();
+        return;
+    }
+    
+    //relink the tree around the node, then take care of its heap memory
+    erase_node(to_be_removed);
+    delete to_be_removed;
+}
+
+/** Definition of the find function, that searches the tree for a value.
+ 
+ @param value you want to look up
+ @return a TreeIterator to the node holding the value, or end() if it is not in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> BinarySearchTree<T,CMP,AUG>::find(const T& data)
+{
+    //a value the filter rules out needs no search
+    if (filter_rejects(data)) return end();
+    //the hash index holds every live value, so its answer is final
+    if (index.enabled())
+    {
+        ++treeStats.index_lookups;
+        TreeNode<T,CMP,AUG>* hit = index.find(data);
+        if (hit == nullptr)
+        {
+            if (filterHash != nullptr) ++treeStats.filter_false_positives;
+            return end();
+        }
+        touch(hit);
+        return iterator_at(hit);
+    }
+    TreeNode<T,CMP,AUG>* parent2;
+    bool as_left;
+    TreeNode<T,CMP,AUG>* found = find_position(data, parent2, as_left);
+    //not found (or only a tombstone) means the end iterator
+    if (found == nullptr || found->erased)
+    {
+        if (filterHash != nullptr) ++treeStats.filter_false_positives;
+        return end();
+    }
+    touch(found);
+    return iterator_at(found);
+}
+
+/** Definition of the contains function, that checks the filter and then searches the tree. Unlike find it never splays, so it only reads the tree.
+ 
+ @param value you want to look up
+ @return true if the value is in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+bool BinarySearchTree<T,CMP,AUG>::contains(const T& data)
+{
+    if (filter_rejects(data)) return false;
+    if (index.enabled())
+    {
+        ++treeStats.index_lookups;
+        if (index.find(data) != nullptr) return true;
+        if (filterHash != nullptr) ++treeStats.filter_false_positives;
+        return false;
+    }
+    TreeNode<T,CMP,AUG>* parent2;
+    bool as_left;
+    TreeNode<T,CMP,AUG>* found = find_position(data, parent2, as_left);
+    if (found == nullptr || found->erased)
+    {
+        if (filterHash != nullptr) ++treeStats.filter_false_positives;
+        return false;
+    }
+    return true;
+}
+
+/** Definition of the aggregate function, that combines the summaries of the values in [lo, hi) in order. It walks down to the highest node
+ inside the range, then down its left subtree along the lo boundary and down its right subtree along the hi boundary. Every subtree hanging
+ inside the range is taken whole from its stored summary, so this costs O(height) combines: O(log n) for a balanced tree (after compact() or
+ merge_sorted) or with splaying on.
+ 
+ @param lo is the first value of the range
+ @param hi is one after the last value of the range
+ @return the combined summary, or the identity if no value is in the range
+ */
+template <typename T,typename CMP,typename AUG>
+typename AUG::summary_type BinarySearchTree<T,CMP,AUG>::aggregate(const T& lo, const T& hi) const
+{
+    //find the highest node in the range, everything in the range is in its subtree
+    TreeNode<T,CMP,AUG>* split = root;
+    while (split != nullptr && split != endNode)
+    {
+        if (isless(split->data, lo))
+            split = split->right;
+        else if (!isless(split->data, hi))
+            split = split->left;
+        else
+            break;
+    }
+    if (split == nullptr || split == endNode)
+        return AUG::identity();
+    
+    //values of the left subtree that are not less than lo, gathered from right to left
+    typename AUG::summary_type left_part = AUG::identity();
+    for (TreeNode<T,CMP,AUG>* N = split->left; N != nullptr; )
+    {
+        if (isless(N->data, lo))
+            N = N->right;
+        else
+        {
+            left_part = AUG::combine(AUG::combine(value_summary(N), subtree_summary(N->right)), left_part);
+            N = N->left;
+        }
+    }
+    //values of the right subtree that are less than hi, gathered from left to right
+    typename AUG::summary_type right_part = AUG::identity();
+    for (TreeNode<T,CMP,AUG>* N = split->right; N != nullptr && N != endNode; )
+    {
+        if (isless(N->data, hi))
+        {
+            right_part = AUG::combine(right_part, AUG::combine(subtree_summary(N->left), value_summary(N)));
+            N = N->right;
+        }
+        else
+            N = N->left;
+    }
+    return AUG::combine(AUG::combine(left_part, value_summary(split)), right_part);
+}
+
+/** Definition of the subtree_summary function
+ 
+ @param N is the root of the subtree
+ @return its stored summary, or the identity if N is nullptr or the endNode
+ */
+template <typename T,typename CMP,typename AUG>
+typename AUG::summary_type BinarySearchTree<T,CMP,AUG>::subtree_summary(const TreeNode<T,CMP,AUG>* N) const
+{
+    if constexpr (std::is_same<AUG,NoSummary>::value)
+        return AUG::identity();
+    else
+    {
+        if (N == nullptr || N == endNode) return AUG::identity();
+        return N->summary;
+    }
+}
+
+/** Definition of the value_summary function
+ 
+ @param N is a node holding a value
+ @return the summary of its value alone, or the identity if it is a tombstone
+ */
+template <typename T,typename CMP,typename AUG>
+typename AUG::summary_type BinarySearchTree<T,CMP,AUG>::value_summary(const TreeNode<T,CMP,AUG>* N) const
+{
+    if (N->erased) return AUG::identity();
+    return AUG::from_value(N->data);
+}
+
+/** Definition of the update_summary function, that recomputes the summary of N from its children's summaries and its own value. Does nothing
+ with NoSummary.
+ 
+ @param N is the node to recompute
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::update_summary(TreeNode<T,CMP,AUG>* N)
+{
+    if constexpr (!std::is_same<AUG,NoSummary>::value)
+        N->summary = AUG::combine(AUG::combine(subtree_summary(N->left), value_summary(N)), subtree_summary(N->right));
+}
+
+/** Definition of the update_path function, that recomputes the summaries from N up to the root after N's subtree changed. Does nothing
+ with NoSummary.
+ 
+ @param N is the lowest node whose subtree changed
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::update_path(TreeNode<T,CMP,AUG>* N)
+{
+    if constexpr (!std::is_same<AUG,NoSummary>::value)
+    {
+        for (; N != nullptr; N = N->parent)
+            update_summary(N);
+    }
+}
+
+/** Definition of the lower_bound function, that searches the tree for the first value that is not less than data.
+ 
+ @param value you want to look up
+ @return a TreeIterator to the first value not less than data, or end() if every value is less
+ */
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> BinarySearchTree<T,CMP,AUG>::lower_bound(const T& data)
+{
+    //the last node we went left from is the smallest one bigger than data seen so far
+    TreeNode<T,CMP,AUG>* candidate = endNode;
+    TreeNode<T,CMP,AUG>* cur = root;
+    while (cur != nullptr && cur != endNode)
+    {
+        if (isless(cur->data, data))
+            cur = cur->right;
+        else
+        {
+            candidate = cur;
+            if (!isless(data, cur->data)) break;
+            cur = cur->left;
+        }
+    }
+    TreeIterator<T,CMP,AUG> iter = iterator_at(candidate);
+    //a tombstone does not count, the next live value does
+    if (candidate != nullptr && candidate->erased)
+        ++iter;
+    return iter;
+}
+
+/** Definition of the find_many function, that looks up a batch of keys. It gives the same answers as calling find for each key, but walks
+ down for several keys at once so their cache misses overlap instead of waiting on each other.
+ 
+ @param keys you want to look up
+ @param results is resized to hold one TreeIterator per key, end() for keys that are not in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::find_many(const std::vector<T>& keys, std::vector<TreeIterator<T,CMP,AUG>>& results)
+{
+    descend_many(keys, results, false);
+}
+
+/** Definition of the lower_bound_many function, that is lower_bound for a batch of keys, interleaved the same way as find_many.
+ 
+ @param keys you want to look up
+ @param results is resized to hold one TreeIterator per key
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::lower_bound_many(const std::vector<T>& keys, std::vector<TreeIterator<T,CMP,AUG>>& results)
+{
+    descend_many(keys, results, true);
+}
+
+/** Definition of the descend_many function. Each step of a single lookup needs the node loaded by the step before it, so one lookup at a time
+ leaves the CPU waiting on memory at every level. Here a group of lookups takes turns: each one moves down a level and prefetches the node it
+ will look at next, and by the time its turn comes round again that node has usually arrived. A lookup that finishes hands its place to the next
+ key right away, so the group stays full until the keys run out.
+ 
+ @param keys you want to look up
+ @param results is resized to hold one TreeIterator per key
+ @param lower is true for lower_bound answers, false for find answers
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::descend_many(const std::vector<T>& keys, std::vector<TreeIterator<T,CMP,AUG>>& results, bool lower)
+{
+    //lookups in flight, enough to cover memory latency without spilling the group out of registers and L1
+    const std::size_t group = 16;
+    struct Lookup
+    {
+        std::size_t index;
+        TreeNode<T,CMP,AUG>* cur;
+        TreeNode<T,CMP,AUG>* candidate;
+    };
+    Lookup lookups[group];
+    results.resize(keys.size());
+
+    std::size_t next = 0;
+    std::size_t active = 0;
+    for (; active < group && next < keys.size(); ++active, ++next)
+        lookups[active] = Lookup{next, root, endNode};
+
+    while (active > 0)
+    {
+        for (std::size_t i = 0; i < active; )
+        {
+            Lookup& lookup = lookups[i];
+            const T& key = keys[lookup.index];
+            TreeNode<T,CMP,AUG>* cur = lookup.cur;
+            bool done = false;
+            TreeNode<T,CMP,AUG>* answer = endNode;
+
+            //move down one level
+            if (cur == nullptr || cur == endNode)
+            {
+                done = true;
+                answer = lower ? lookup.candidate : endNode;
+            }
+            else if (isless(key, cur->data))
+            {
+                lookup.candidate = cur;
+                lookup.cur = cur->left;
+            }
+            else if (isless(cur->data, key))
+                lookup.cur = cur->right;
+            else
+            {
+                done = true;
+                answer = cur;
+            }
+
+            if (!done)
+            {
+                BST_PREFETCH(lookup.cur);
+                ++i;
+                continue;
+            }
+
+            TreeIterator<T,CMP,AUG> iter = iterator_at(answer);
+            //tombstones are not found, and lower_bound moves on to the next live value
+            if (answer != nullptr && answer->erased)
+            {
+                if (lower) ++iter;
+                else iter = end();
+            }
+            results[lookup.index] = iter;
+
+            //start the next key in this place, or close the gap
+            if (next < keys.size())
+            {
+                lookup = Lookup{next++, root, endNode};
+                ++i;
+            }
+            else
+                lookups[i] = lookups[--active];
+        }
+    }
+}
+
+/** Definition of the find_position function, that walks down from the root looking for a key. The key can be of any type the comparator accepts
+ against T, which lets the map variant search by key alone.
+ 
+ @param key we are looking for
+ @param parent2 is set to the node a new node would be linked under (nullptr if the tree is empty)
+ @param as_left is set to true if a new node would become the left child of parent2
+ @return the node holding key, or nullptr if it is not in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename K>
+TreeNode<T,CMP,AUG>* BinarySearchTree<T,CMP,AUG>::find_position(const K& key, TreeNode<T,CMP,AUG>*& parent2, bool& as_left) const
+{
+    return descend(root, key, parent2, as_left);
+}
+
+/** Definition of the descend function, that walks down from start looking for a key. The caller must know that key's position lies inside
+ the subtree rooted at start.
+ 
+ @param start is the root of the subtree to search
+ @param key we are looking for
+ @param parent2 is set to the node a new node would be linked under (start's parent if start is empty)
+ @param as_left is set to true if a new node would become the left child of parent2
+ @return the node holding key, or nullptr if it is not in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename K>
+TreeNode<T,CMP,AUG>* BinarySearchTree<T,CMP,AUG>::descend(TreeNode<T,CMP,AUG>* start, const K& key, TreeNode<T,CMP,AUG>*& parent2, bool& as_left) const
+{
+    TreeNode<T,CMP,AUG>* cur = start;
+    parent2 = nullptr;
+    as_left = false;
+    //the endNode holds no data, so it ends the search just like an empty subtree
+    while (cur != nullptr && cur != endNode)
+    {
+        //search left side of tree if key is less than current node
+        if (isless(key, cur->data))
+        {
+            parent2 = cur;
+            as_left = true;
+            cur = cur->left;
+        }
+        //search right side of the tree if key is greater than current node
+        else if (isless(cur->data, key))
+        {
+            parent2 = cur;
+            as_left = false;
+            cur = cur->right;
+        }
+        else return cur;
+    }
+    return nullptr;
+}
+
+/** Definition of the hinted find_position function. It checks, in order, whether key goes after the largest node or before the smallest node,
+ whether it sits between hint and its predecessor, or between hint and its successor. Each check only looks at neighbours, so it costs amortised O(1). If none of them
+ match it climbs from hint only as far as the first ancestor whose subtree must hold key, and searches down from there. Sorted batches inserted
+ with the previous result as the hint therefore cost about the log of the distance between neighbouring keys, not the height of the tree.
+ 
+ @param hint is the node to start from (nullptr or the endNode only check the append and prepend cases)
+ @param key we are looking for
+ @param parent2 is set to the node a new node would be linked under (nullptr if the tree is empty)
+ @param as_left is set to true if a new node would become the left child of parent2
+ @return the node holding key, or nullptr if it is not in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename K>
+TreeNode<T,CMP,AUG>* BinarySearchTree<T,CMP,AUG>::find_position(TreeNode<T,CMP,AUG>* hint, const K& key, TreeNode<T,CMP,AUG>*& parent2, bool& as_left)
+{
+    //an empty tree has nothing to start from
     if (root == nullptr)
+        return find_position(key, parent2, as_left);
+    
+    //if key is greater than the largest node, it goes between the largest node and the endNode
+    TreeNode<T,CMP,AUG>* largest = endNode->parent;
+    if (isless(largest->data, key))
+    {
+        parent2 = largest;
+        as_left = false;
+        return nullptr;
+    }
+    //if key is less than the smallest node, it becomes the left child of the smallest node
+    if (isless(key, beginNode->data))
+    {
+        parent2 = beginNode;
+        as_left = true;
+        return nullptr;
+    }
+    
+    //without a hint, search from the root
+    if (hint == nullptr || hint == endNode)
+        return find_position(key, parent2, as_left);
+    
+    //if key is less than hint, check that it is greater than the node before hint
+    if (isless(key, hint->data))
+    {
+        TreeNode<T,CMP,AUG>* before = TreeIterator<T,CMP,AUG>::prev_node(hint);
+        if (before == nullptr || isless(before->data, key))
+        {
+            //the free spot between the two is hint's left child, or else the right child of the node before
+            if (hint->left == nullptr)
+            {
+                parent2 = hint;
+                as_left = true;
+            }
+            else
+            {
+                parent2 = before;
+                as_left = false;
+            }
+            return nullptr;
+        }
+    }
+    //if key is greater than hint, check that it is less than the node after hint
+    else if (isless(hint->data, key))
+    {
+        TreeNode<T,CMP,AUG>* after = TreeIterator<T,CMP,AUG>::next_node(hint);
+        if (isless(key, after->data))
+        {
+            //the free spot between the two is hint's right child, or else the left child of the node after
+            if (hint->right == nullptr)
+            {
+                parent2 = hint;
+                as_left = false;
+            }
+            else
+            {
+                parent2 = after;
+                as_left = true;
+            }
+            return nullptr;
+        }
+    }
+    //key is equal to hint
+    else return hint;
+    
+    //the hint was not next to key, so climb until the subtree below the current node must hold key's position
+    bool key_after_hint = isless(hint->data, key);
+    TreeNode<T,CMP,AUG>* cur = hint;
+    while (cur->parent != nullptr)
+    {
+        TreeNode<T,CMP,AUG>* up = cur->parent;
+        //only an ancestor on key's side of the subtree can bound it, the others are passed on the way up
+        if (key_after_hint ? (up->left == cur) : (up->right == cur))
+        {
+            if (key_after_hint ? isless(key, up->data) : isless(up->data, key))
+                break;
+            if (!isless(key, up->data) && !isless(up->data, key))
+                return up;
+        }
+        cur = up;
+    }
+    return descend(cur, key, parent2, as_left);
+}
+
+/** Definition of the link_node function, that hangs a new node under the position found by find_position and keeps the endNode after the largest node.
+ 
+ @param new_node is the node to link into the tree
+ @param parent2 is the node it goes under (nullptr if the tree is empty)
+ @param as_left is true if new_node becomes the left child of parent2
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::link_node(TreeNode<T,CMP,AUG>* new_node, TreeNode<T,CMP,AUG>* parent2, bool as_left)
+{
+    new_node->parent = parent2;
+    ++treeStats.size;
+    //if the tree is empty
+    if (parent2 == nullptr)
     {
         //make the new TreeNode the root of the tree
         root = new_node;
-        new_node->parent=nullptr;
-        
-        //create a new TreeNode to be the end node
-        endNode=new TreeNode<T,CMP>(*this);
-        //set its initial data
-        endNode->data=data;
+        beginNode = new_node;
+        //create the end node the first time the tree gets an element
+        if (endNode == nullptr)
+            endNode = new TreeNode<T,CMP,AUG>();
         //link properly
         new_node->right = endNode;
-        endNode->parent=root;
-        endNode->right=nullptr;
-        endNode->left=nullptr;
-        //end node left and rights
+        endNode->parent = root;
+    }
+    else if (as_left)
+    {
+        parent2->left = new_node;
+        //hanging off the left of the smallest node makes it the new smallest node
+        if (parent2 == beginNode)
+            beginNode = new_node;
     }
-    //if the tree is not empty, insert new node correctly into the tree using TreeNode's insert function
-    else root->insert_node(new_node);
+    else
+    {
+        //if the new node is the new largest node, the endNode moves down after it
+        if (parent2->right == endNode)
+        {
+            new_node->right = endNode;
+            endNode->parent = new_node;
+        }
+        parent2->right = new_node;
+    }
+    update_path(new_node);
+    
+    //add the value to the filter, or refill a bigger one once the tree has outgrown it
+    if (filterHash != nullptr)
+    {
+        if (treeStats.size > filter.capacity())
+            rebuild_filter();
+        else
+            filter.add(filterHash(new_node->data));
+    }
+    if (index.enabled())
+        index.insert(new_node);
 }
 
-/** Definition of the erase function, that first tries to find the inputed value in the tree, and if found, removes it from the tree and relinks the tree safely.
+/** Definition of the erase_node function, that unlinks a node from the tree and relinks its subtrees. The node itself is not deleted, and no data is copied
+ between nodes, so iterators to other nodes stay valid.
+ 
+ @param N is the node to remove from the tree
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::erase_node(TreeNode<T,CMP,AUG>* N)
+{
+    //keep count of what is linked into the tree, a tombstone already counted as stale in the filter when it was erased
+    bool was_live = !N->erased;
+    if (N->erased)
+        --treeStats.tombstones;
+    else
+        --treeStats.size;
+    
+    //if N is the smallest node, the node after it becomes the smallest
+    if (N == beginNode)
+    {
+        TreeNode<T,CMP,AUG>* next = TreeIterator<T,CMP,AUG>::next_node(N);
+        beginNode = (next == endNode) ? nullptr : next;
+    }
+    
+    //the endNode counts as an empty right subtree
+    TreeNode<T,CMP,AUG>* right_child = (N->right == endNode) ? nullptr : N->right;
+    //the lowest node whose subtree loses N, where the summaries need recomputing from
+    TreeNode<T,CMP,AUG>* changed = N->parent;
+    
+    // If the left child is empty, the right child (or the endNode) takes N's place
+    if (N->left == nullptr)
+        replace_child(N, N->right);
+    // If only the right child is empty, use the left child
+    else if (right_child == nullptr)
+    {
+        TreeNode<T,CMP,AUG>* left_child = N->left;
+        replace_child(N, left_child);
+        //if N was the largest node, the endNode moves after the largest node of its left subtree
+        if (N->right == endNode)
+        {
+            TreeNode<T,CMP,AUG>* largest = left_child;
+            while (largest->right != nullptr)
+                largest = largest->right;
+            largest->right = endNode;
+            endNode->parent = largest;
+        }
+    }
+    // If neither subtree is empty, the smallest node of the right subtree takes N's place
+    else
+    {
+        TreeNode<T,CMP,AUG>* smallest = right_child;
+        while (smallest->left != nullptr)
+            smallest = smallest->left;
+        //detach smallest from deeper in the right subtree
+        changed = smallest;
+        if (smallest->parent != N)
+        {
+            changed = smallest->parent;
+            replace_child(smallest, smallest->right);
+            smallest->right = N->right;
+            smallest->right->parent = smallest;
+        }
+        replace_child(N, smallest);
+        smallest->left = N->left;
+        smallest->left->parent = smallest;
+    }
+    
+    //if only the endNode is left the tree is empty
+    if (root == endNode)
+    {
+        root = nullptr;
+        endNode->parent = nullptr;
+    }
+    if (changed != nullptr && changed != endNode)
+        update_path(changed);
+    
+    if (was_live)
+    {
+        filter_remove();
+        if (index.enabled())
+            index.erase(N);
+    }
+}
+
+/** Definition of the replace_child function, that links the subtree new_child into the parent of N in the place of N.
  
- @param integer value of the node you want to remove from the tree
+ @param N is the node being replaced
+ @param new_child is the subtree taking its place (may be nullptr)
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::replace_child(TreeNode<T,CMP,AUG>* N, TreeNode<T,CMP,AUG>* new_child)
+{
+    //if N is the root, the root now points to the new child
+    if (N->parent == nullptr)
+        root = new_child;
+    //if N is a left child, re-link the left child of the parent
+    else if (N->parent->left == N)
+        N->parent->left = new_child;
+    //if N is a right child, re-link the right child of the parent
+    else
+        N->parent->right = new_child;
+    //set parent correctly
+    if (new_child != nullptr)
+        new_child->parent = N->parent;
+}
+
+/** Definition of the iterator_at function, that wraps a node in a TreeIterator.
  
+ @param N is the node the iterator points at
+ @return a TreeIterator pointing at N
  */
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> BinarySearchTree<T,CMP,AUG>::iterator_at(TreeNode<T,CMP,AUG>* N)
+{
+    TreeIterator<T,CMP,AUG> iter;
+    iter.node = N;
+    return iter;
+}
 
-template <typename T,typename CMP>
-void BinarySearchTree<T,CMP>::erase(T data)
+/** Definition of the revive function, that links a fresh node into the exact place of a tombstone holding an equal key and frees the tombstone.
+ 
+ @param tombstone is the erased node being replaced
+ @param fresh is the new node, not yet linked into the tree
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::revive(TreeNode<T,CMP,AUG>* tombstone, TreeNode<T,CMP,AUG>* fresh)
 {
-    // Find node to be removed
-    TreeNode<T,CMP>* to_be_removed = root;
-    TreeNode<T,CMP>* parent2 = nullptr;
-    bool found = false;
-    while (!found && to_be_removed != nullptr)
+    //take over the tombstone's children and parent
+    fresh->left = tombstone->left;
+    fresh->right = tombstone->right;
+    replace_child(tombstone, fresh);
+    if (fresh->left != nullptr)
+        fresh->left->parent = fresh;
+    //this also moves the endNode if the tombstone was the largest node
+    if (fresh->right != nullptr)
+        fresh->right->parent = fresh;
+    if (beginNode == tombstone)
+        beginNode = fresh;
+    
+    --treeStats.tombstones;
+    ++treeStats.size;
+    update_path(fresh);
+    free_node(tombstone);
+    if (filterHash != nullptr)
+        filter.add(filterHash(fresh->data));
+    //the tombstone was taken out of the index when it was erased
+    if (index.enabled())
+        index.insert(fresh);
+}
+
+/** Definition of the make_node function, that creates a node from the given constructor arguments. Memory from the spare list is reused
+ before any new memory is allocated.
+ 
+ @param args are the constructor arguments of the node's data
+ @return the new node, not yet linked into the tree
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename... Args>
+TreeNode<T,CMP,AUG>* BinarySearchTree<T,CMP,AUG>::make_node(Args&&... args)
+{
+    //no spare nodes, allocate a new one
+    if (spareNodes == nullptr)
+        return new TreeNode<T,CMP,AUG>(std::forward<Args>(args)...);
+    
+    //take the first spare node off the list and build the node in its memory
+    void* mem = spareNodes;
+    spareNodes = *static_cast<void**>(mem);
+    --treeStats.spare_nodes;
+    ++treeStats.recycled_nodes;
+    return ::new (mem) TreeNode<T,CMP,AUG>(std::forward<Args>(args)...);
+}
+
+/** Definition of the free_node function, that destroys a node which is no longer linked into the tree and keeps its memory on the spare list.
+ 
+ @param N is the node to free
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::free_node(TreeNode<T,CMP,AUG>* N)
+{
+    void* mem = N;
+    N->~TreeNode();
+    //the memory now only holds the link to the next spare node
+    ::new (mem) void*(spareNodes);
+    spareNodes = mem;
+    ++treeStats.spare_nodes;
+}
+
+/** Definition of the set_lazy_erase function. In lazy erase mode erase marks nodes as tombstones instead of unlinking and deleting them, and the
+ tree is compacted once tombstones are more than max_tombstone_ratio of its nodes. Turning lazy erase off keeps existing tombstones until the
+ next compact().
+ 
+ @param lazy is true to turn lazy erase on
+ @param max_tombstone_ratio is the fraction of tombstones that triggers compaction (1 or more never compacts on its own)
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::set_lazy_erase(bool lazy, double max_tombstone_ratio)
+{
+    lazyErase = lazy;
+    maxTombstoneRatio = max_tombstone_ratio;
+}
+
+/** Definition of the compact function. It walks the tree once in order, moves tombstones to the spare list, and relinks the remaining nodes
+ into a balanced tree. No data is moved, so iterators to values in the tree stay valid. This also rebalances a tree that never had tombstones.
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::compact()
+{
+    //collect the nodes in order, keeping tombstones until the walk is done since the walk goes through their parent links
+    std::vector<TreeNode<T,CMP,AUG>*> nodes;
+    std::vector<TreeNode<T,CMP,AUG>*> tombstones;
+    nodes.reserve(treeStats.size);
+    tombstones.reserve(treeStats.tombstones);
+    for (TreeNode<T,CMP,AUG>* N = beginNode; N != nullptr && N != endNode; N = TreeIterator<T,CMP,AUG>::next_node(N))
+    {
+        if (N->erased)
+            tombstones.push_back(N);
+        else
+            nodes.push_back(N);
+    }
+    for (TreeNode<T,CMP,AUG>* N : tombstones)
+        free_node(N);
+    treeStats.tombstones = 0;
+    ++treeStats.compactions;
+    
+    //relink what is left
+    rebuild(nodes);
+}
+
+/** Definition of the merge_sorted function. It walks the tree once in order alongside the sorted range, creates nodes for the new values,
+ drops tombstones like compact(), and relinks everything into a balanced tree. This costs O(n + m) for n nodes and m new values, so it pays off
+ for batches that are a sizeable fraction of the tree. Values already in the tree, and repeats within the range, keep the first copy like insert.
+ 
+ @param first is the start of the sorted range of values to add
+ @param last is one after the end of the range
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename InputIt>
+void BinarySearchTree<T,CMP,AUG>::merge_sorted(InputIt first, InputIt last)
+{
+    std::vector<TreeNode<T,CMP,AUG>*> nodes;
+    std::vector<TreeNode<T,CMP,AUG>*> tombstones;
+    nodes.reserve(treeStats.size);
+    tombstones.reserve(treeStats.tombstones);
+    
+    //true if value repeats the last node we kept
+    auto repeats_last = [&](const T& value) {
+        return !nodes.empty() && !isless(nodes.back()->data, value);
+    };
+    
+    for (TreeNode<T,CMP,AUG>* N = beginNode; N != nullptr && N != endNode; N = TreeIterator<T,CMP,AUG>::next_node(N))
     {
-        //search right side of the tree if the data value is greater than current ptr
-        if (to_be_removed->data < data)
+        if (N->erased)
         {
-            parent2 = to_be_removed;
-            to_be_removed = to_be_removed->right;
+            tombstones.push_back(N);
+            continue;
         }
-        //search left side of tree if data value is less than current ptr
-        else if (data < to_be_removed->data)
+        //new values that go before N
+        for (; first != last && isless(*first, N->data); ++first)
         {
-            parent2 = to_be_removed;
-            to_be_removed = to_be_removed->left;
+            if (!repeats_last(*first))
+                nodes.push_back(make_node(*first));
         }
-        else found = true;
+        //new values equal to N are dropped, the tree keeps its own copy
+        while (first != last && !isless(N->data, *first))
+            ++first;
+        nodes.push_back(N);
+    }
+    //new values after the largest node
+    for (; first != last; ++first)
+    {
+        if (!repeats_last(*first))
+            nodes.push_back(make_node(*first));
     }
     
-    //if we could not find the tree, exit the function
-    if (!found) return;
+    for (TreeNode<T,CMP,AUG>* N : tombstones)
+        free_node(N);
+    treeStats.tombstones = 0;
+    treeStats.size = nodes.size();
+    //a tree that was never filled has no endNode yet
+    if (endNode == nullptr && !nodes.empty())
+        endNode = new TreeNode<T,CMP,AUG>();
+    rebuild(nodes);
+    //new values were linked without going through link_node
+    if (filterHash != nullptr)
+        rebuild_filter();
+    if (index.enabled())
+        rebuild_index();
+}
+
+/** Definition of the set_capacity function. Values beyond the new capacity are dropped from the small end right away. Only offer is bounded,
+ insert and merge_sorted still add every value.
+ 
+ @param capacity is the most values offer keeps, 0 for no limit
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::set_capacity(std::size_t capacity)
+{
+    maxSize = capacity;
+    while (maxSize != 0 && treeStats.size > maxSize)
+        pop_min();
+}
+
+/** Definition of the offer function, that keeps the capacity largest values seen (the smallest ones when CMP is std::greater). While the tree
+ has room this is a plain insert. Once it is full a value that is not bigger than the smallest value is turned away after one comparison.
+ Otherwise the smallest node is recycled for the new value: if the value sorts before the node after it, the data is overwritten in place,
+ and if not, the node is unlinked and linked again where the value belongs. Either way nothing is allocated or freed.
+ 
+ @param value you want to offer
+ @return true if the value was added to the tree
+ */
+template <typename T,typename CMP,typename AUG>
+bool BinarySearchTree<T,CMP,AUG>::offer(T data)
+{
+    if (maxSize == 0 || treeStats.size < maxSize)
+    {
+        std::size_t old_size = treeStats.size;
+        insert(end(), std::move(data));
+        return treeStats.size > old_size;
+    }
+    //clear out tombstones sitting in front of the smallest value, so beginNode holds the value to beat
+    while (beginNode->erased)
+    {
+        TreeNode<T,CMP,AUG>* tombstone = beginNode;
+        erase_node(tombstone);
+        free_node(tombstone);
+    }
+    TreeNode<T,CMP,AUG>* N = beginNode;
+    if (!isless(N->data, data))
+    {
+        ++treeStats.rejected_offers;
+        return false;
+    }
     
-    // If one of the children is empty, use the other
-    if (to_be_removed->left == nullptr || to_be_removed->right == nullptr)
-    {
-        TreeNode<T,CMP>* new_child;
-        //if the empy child is the left child
-        if (to_be_removed->left == nullptr)
-            //the new_child becomes the right child
-            new_child = to_be_removed->right;
-        else
-            //else the new child becomes the right child
-            new_child = to_be_removed->left;
-        
-        //if the node we want to remove is the root
-        if (parent2 == nullptr)
+    //if the value still sorts before the next node, the smallest node can keep its place
+    TreeNode<T,CMP,AUG>* next = TreeIterator<T,CMP,AUG>::next_node(N);
+    if (next == endNode || isless(data, next->data))
+    {
+        //the index finds the node by the hash of its old value
+        if (index.enabled())
+            index.erase(N);
+        N->data = std::move(data);
+        ++treeStats.in_place_offers;
+        update_path(N);
+        if (filterHash != nullptr)
         {
-            //the root now points to the new child
-            root = new_child;
-            new_child->parent=nullptr;
+            filter_remove();
+            filter.add(filterHash(N->data));
         }
-        //if the node we want to remove is a left child
-        else if (parent2->left == to_be_removed)
+        if (index.enabled())
+            index.insert(N);
+        return true;
+    }
+    
+    //the value is bigger than the node after the smallest, so the search never ends under the smallest node
+    TreeNode<T,CMP,AUG>* parent2;
+    bool as_left;
+    TreeNode<T,CMP,AUG>* found = find_position(data, parent2, as_left);
+    if (found != nullptr && !found->erased) return false;
+    //unlinking the smallest node only moves its right subtree up, so the position found above stays valid
+    erase_node(N);
+    N->data = std::move(data);
+    N->left = nullptr;
+    N->right = nullptr;
+    if (found != nullptr)
+        revive(found, N);
+    else
+        link_node(N, parent2, as_left);
+    return true;
+}
+
+/** Definition of the set_filter function. With the filter on, find and contains first ask a blocked Bloom filter of the values in the tree,
+ and only search the tree if the filter says the value may be there. When most lookups are for missing values, most of them then cost one
+ cache line instead of a walk down the tree. The filter is sized for twice the values in the tree and refilled from the tree when the tree
+ outgrows it. Erased values leave their bits behind, which only raises the false positive rate, so the filter is also refilled once the
+ erased values reach half its size. Values are hashed with TreeHash<T,CMP>, so they must have one.
+ 
+ @param enabled is true to build the filter, false to drop it
+ @param false_positive_rate is the fraction of missing values the filter should let through to the tree
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::set_filter(bool enabled, double false_positive_rate)
+{
+    filterRate = false_positive_rate;
+    if (!enabled)
+    {
+        filterHash = nullptr;
+        filter = BlockedBloomFilter();
+        return;
+    }
+    filterHash = &BinarySearchTree<T,CMP,AUG>::value_hash;
+    rebuild_filter();
+}
+
+/** Definition of the filter_rejects function, that asks the filter about a value and counts its answer.
+ 
+ @param value you want to look up
+ @return true if the value is definitely not in the tree, false if the tree has to be searched (always false without a filter)
+ */
+template <typename T,typename CMP,typename AUG>
+bool BinarySearchTree<T,CMP,AUG>::filter_rejects(const T& data)
+{
+    if (filterHash == nullptr) return false;
+    if (!filter.may_contain(filterHash(data)))
+    {
+        ++treeStats.filter_negatives;
+        return true;
+    }
+    ++treeStats.filter_positives;
+    return false;
+}
+
+/** Definition of the filter_remove function, called whenever a value leaves the tree. Its bits can't be cleared, so it is counted as stale
+ and the filter is refilled once stale values are half of what it was sized for.
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::filter_remove()
+{
+    if (filterHash == nullptr) return;
+    if (++staleKeys > filter.capacity() / 2)
+        rebuild_filter();
+}
+
+/** Definition of the rebuild_filter function, that resets the filter for twice the values in the tree and adds every value that is not a tombstone.
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::rebuild_filter()
+{
+    filter.reset(std::max<std::size_t>(2 * treeStats.size, 64), filterRate);
+    for (TreeNode<T,CMP,AUG>* N = beginNode; N != nullptr && N != endNode; N = TreeIterator<T,CMP,AUG>::next_node(N))
+    {
+        if (!N->erased)
+            filter.add(filterHash(N->data));
+    }
+    staleKeys = 0;
+    ++treeStats.filter_rebuilds;
+}
+
+/** Definition of the set_hash_index function. With the index on, find and contains look a value up in a hash table of the live nodes
+ (see HashIndex.h) instead of walking down the tree, which costs one or two cache misses however deep the value is. insert, erase, offer
+ and merge_sorted keep the table up to date, and compact() moves no nodes, so it has nothing to update. Ordered operations (lower_bound,
+ aggregate, iteration) still use the tree. Values are hashed with TreeHash<T,CMP>, so points ordered by PointOrderx hash only their x and
+ find any point with an equal x, just like a search of the tree would. The table costs about 9 bytes per slot, at most 8 slots for 7 values.
+
+ @param enabled is true to build the index, false to drop it
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::set_hash_index(bool enabled)
+{
+    if (!enabled)
+    {
+        index.clear();
+        return;
+    }
+    rebuild_index();
+}
+
+/** Definition of the rebuild_index function, that empties the index, sizes it for the values in the tree, and adds every node that is not a tombstone.
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::rebuild_index()
+{
+    index.reset(&BinarySearchTree<T,CMP,AUG>::value_hash, treeStats.size);
+    for (TreeNode<T,CMP,AUG>* N = beginNode; N != nullptr && N != endNode; N = TreeIterator<T,CMP,AUG>::next_node(N))
+    {
+        if (!N->erased)
+            index.insert(N);
+    }
+}
+
+/** Definition of the value_hash function. It is only used through filterHash and the hash index, which set_filter and set_hash_index point
+ at it, so trees that never turn either on do not need a TreeHash for their values.
+ 
+ @param value to hash
+ @return hash of the value, equal for values the comparator treats as equal
+ */
+template <typename T,typename CMP,typename AUG>
+std::size_t BinarySearchTree<T,CMP,AUG>::value_hash(const T& data)
+{
+    return TreeHash<T,CMP>()(data);
+}
+
+/** Definition of the set_splay_interval function. With splaying on, find and insert move the node they return to the root with splay
+ rotations, so keys that are looked up often stay near the top and cost few comparisons, and the tree adapts as the popular keys change.
+ Each splay rewrites a few pointers along the path, so an interval above 1 only splays every interval-th access to save that work; popular keys
+ still get splayed often. Rotations only relink nodes, so iterators stay valid, and the endNode stays the right child of the largest node.
+ find_many, lower_bound and erase do not splay.
+ 
+ @param interval is how many accesses there are per splay, 1 splays on every access and 0 turns splaying off
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::set_splay_interval(std::size_t interval)
+{
+    splayInterval = interval;
+    accessCount = 0;
+}
+
+/** Definition of the touch function, that counts an access and splays the node once the interval is reached.
+ 
+ @param N is the node that find or insert is about to return
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::touch(TreeNode<T,CMP,AUG>* N)
+{
+    if (splayInterval == 0 || ++accessCount < splayInterval) return;
+    accessCount = 0;
+    splay(N);
+}
+
+/** Definition of the splay function, that brings N to the root with bottom-up splaying: when N and its parent are children on the same side
+ the parent is rotated first (zig-zig), otherwise N is rotated twice (zig-zag). Splaying roughly halves the depth of every node on the path, which
+ is what keeps a sequence of accesses at amortised O(log n) each.
+ 
+ @param N is the node to bring to the root
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::splay(TreeNode<T,CMP,AUG>* N)
+{
+    while (N->parent != nullptr)
+    {
+        TreeNode<T,CMP,AUG>* parent2 = N->parent;
+        TreeNode<T,CMP,AUG>* grandparent = parent2->parent;
+        if (grandparent == nullptr)
+            rotate_up(N);
+        else if ((parent2->left == N) == (grandparent->left == parent2))
         {
-            //re-link the left child of the parent
-            parent2->left = new_child;
-            if (new_child!=nullptr)
-                new_child->parent=parent2;
+            rotate_up(parent2);
+            rotate_up(N);
         }
-        //if the node we want to remove is a right child
         else
         {
-            //relink the right child of the parent
-            parent2->right = new_child;
-            if (new_child != nullptr)
-                new_child->parent=parent2;
+            rotate_up(N);
+            rotate_up(N);
         }
-        //take care of heap memory of deleted node
-        delete to_be_removed;
-        return;
     }
+    ++treeStats.splays;
+}
+
+/** Definition of the rotate_up function, that swaps N with its parent while keeping the order of the tree. The endNode is never rotated: the largest
+ node is never a left child, so the subtree it hands to its old parent is never the endNode, and its right child stays the endNode.
+ 
+ @param N is the node to move up, it must have a parent
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::rotate_up(TreeNode<T,CMP,AUG>* N)
+{
+    TreeNode<T,CMP,AUG>* parent2 = N->parent;
+    //N takes its parent's place under the grandparent
+    replace_child(parent2, N);
+    //the inner subtree of N moves across to the old parent, which becomes N's child
+    if (parent2->left == N)
+    {
+        parent2->left = N->right;
+        if (N->right != nullptr) N->right->parent = parent2;
+        N->right = parent2;
+    }
+    else
+    {
+        parent2->right = N->left;
+        if (N->left != nullptr) N->left->parent = parent2;
+        N->left = parent2;
+    }
+    parent2->parent = N;
+    //the old parent now sits below N, so it is recomputed first
+    update_summary(parent2);
+    update_summary(N);
+    ++treeStats.rotations;
+}
+
+/** Definition of the set_parallel_threads function
+ 
+ @param threads is the number of threads parallel_for_each, parallel_reduce and parallel_transform use, 0 for one per core
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::set_parallel_threads(unsigned threads)
+{
+    parallelThreads = threads;
+}
+
+/** Definition of the parallel_for_each function, that calls fn on every value of the tree using several threads. fn is shared by all threads,
+ so it must be safe to call concurrently, and the values are visited in no particular order. fn may change a value, but not in a way that
+ changes its order. The tree must not be changed while this runs.
+ 
+ @param fn is called with a reference to each value
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename F>
+void BinarySearchTree<T,CMP,AUG>::parallel_for_each(F fn)
+{
+    std::vector<std::pair<TreeNode<T,CMP,AUG>*,bool>> tasks;
+    split_tasks(tasks);
+    run_tasks(tasks.size(), [&](std::size_t i) {
+        if (tasks[i].second)
+            visit_subtree(tasks[i].first, fn);
+        else if (!tasks[i].first->erased)
+            fn(tasks[i].first->data);
+    });
+}
+
+/** Definition of the parallel_reduce function, for when values and partial results combine with the same op (a sum, for example).
+ 
+ @param identity is the starting value of every partial result, so it must not change a result it is combined with
+ @param op is called as op(result, value) and op(result, partial_result)
+ @return the values folded together in order
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename R,typename Op>
+R BinarySearchTree<T,CMP,AUG>::parallel_reduce(R identity, Op op)
+{
+    return parallel_reduce(identity, op, op);
+}
+
+/** Definition of the parallel_reduce function. Each piece of the tree is folded on its own, starting from identity and going through its values
+ in order, and the partial results are then combined from left to right. So the answer is the same as a sequential fold as long as op and combine
+ are associative, even if they are not commutative (joining strings, for example).
+ 
+ @param identity is the starting value of every partial result, so it must not change a result it is combined with
+ @param op is called as op(result, value) to fold in one value
+ @param combine is called as combine(result, partial_result) to join the results of two neighbouring pieces
+ @return the values folded together in order
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename R,typename Op,typename Combine>
+R BinarySearchTree<T,CMP,AUG>::parallel_reduce(R identity, Op op, Combine combine)
+{
+    std::vector<std::pair<TreeNode<T,CMP,AUG>*,bool>> tasks;
+    split_tasks(tasks);
+    //wrapped so that R = bool does not end up in a packed std::vector<bool>
+    struct Partial { R value; };
+    std::vector<Partial> partials(tasks.size(), Partial{identity});
+    run_tasks(tasks.size(), [&](std::size_t i) {
+        //fold into a local so threads do not write to neighbouring partials on every value
+        R result = identity;
+        auto fold = [&](T& value) { result = op(std::move(result), value); };
+        if (tasks[i].second)
+            visit_subtree(tasks[i].first, fold);
+        else if (!tasks[i].first->erased)
+            fold(tasks[i].first->data);
+        partials[i].value = std::move(result);
+    });
     
-    // If neither subtree is empty
+    R result = identity;
+    for (Partial& partial : partials)
+        result = combine(std::move(result), std::move(partial.value));
+    return result;
+}
+
+/** Definition of the parallel_transform function, that applies fn to every value on several threads. Each piece of the tree collects its own
+ results, and they are joined in order at the end.
+ 
+ @param fn is called with a reference to each value, and must be safe to call concurrently
+ @return the results of fn in the order of the values
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename F>
+auto BinarySearchTree<T,CMP,AUG>::parallel_transform(F fn) -> std::vector<typename std::decay<decltype(fn(std::declval<T&>()))>::type>
+{
+    typedef typename std::decay<decltype(fn(std::declval<T&>()))>::type R;
+    std::vector<std::pair<TreeNode<T,CMP,AUG>*,bool>> tasks;
+    split_tasks(tasks);
+    std::vector<std::vector<R>> pieces(tasks.size());
+    run_tasks(tasks.size(), [&](std::size_t i) {
+        auto apply = [&](T& value) { pieces[i].push_back(fn(value)); };
+        if (tasks[i].second)
+            visit_subtree(tasks[i].first, apply);
+        else if (!tasks[i].first->erased)
+            apply(tasks[i].first->data);
+    });
     
-    // Find largest element of the left subtree
-    TreeNode<T,CMP>* largest_parent = to_be_removed;
-    TreeNode<T,CMP>* largest = to_be_removed->left;
-    //find the right most element of the left subtree
-    while (largest->right != nullptr)
+    std::vector<R> results;
+    results.reserve(treeStats.size);
+    for (std::vector<R>& piece : pieces)
+        results.insert(results.end(), std::make_move_iterator(piece.begin()), std::make_move_iterator(piece.end()));
+    return results;
+}
+
+/** Definition of the split_tasks function. The tree does not keep subtree sizes, so it is split by shape: starting from the whole tree, each
+ round replaces every subtree by its left subtree, its root on its own and its right subtree, which keeps the pieces in order. Rounds continue
+ until there are about eight subtrees per thread, so threads that finish early can pick up more. A balanced tree (after compact() or
+ merge_sorted) splits evenly. A lopsided one gives uneven pieces, and the number of rounds is capped so a long spine cannot blow up the list.
+ 
+ @param tasks is filled with the pieces in order, each a node and true if its whole subtree belongs to the piece
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::split_tasks(std::vector<std::pair<TreeNode<T,CMP,AUG>*,bool>>& tasks) const
+{
+    unsigned threads = parallelThreads ? parallelThreads : std::thread::hardware_concurrency();
+    std::size_t target = 8 * static_cast<std::size_t>(threads ? threads : 1);
+    tasks.clear();
+    if (root != nullptr && root != endNode)
+        tasks.push_back(std::make_pair(root, true));
+    
+    std::vector<std::pair<TreeNode<T,CMP,AUG>*,bool>> next;
+    for (int round = 0; round < 64; ++round)
     {
-        largest_parent = largest;
-        largest = largest->right;
+        std::size_t subtrees = 0;
+        for (const std::pair<TreeNode<T,CMP,AUG>*,bool>& task : tasks)
+            subtrees += task.second;
+        if (subtrees == 0 || subtrees >= target) break;
+        
+        next.clear();
+        for (const std::pair<TreeNode<T,CMP,AUG>*,bool>& task : tasks)
+        {
+            TreeNode<T,CMP,AUG>* N = task.first;
+            if (!task.second)
+            {
+                next.push_back(task);
+                continue;
+            }
+            if (N->left != nullptr)
+                next.push_back(std::make_pair(N->left, true));
+            next.push_back(std::make_pair(N, false));
+            if (N->right != nullptr && N->right != endNode)
+                next.push_back(std::make_pair(N->right, true));
+        }
+        tasks.swap(next);
     }
+}
+
+/** Definition of the visit_subtree function, an in-order walk with an explicit stack. It only reads child pointers downwards, so it never
+ leaves the subtree, and it skips the endNode and tombstones.
+ 
+ @param N is the root of the subtree
+ @param fn is called with a reference to each value
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename F>
+void BinarySearchTree<T,CMP,AUG>::visit_subtree(TreeNode<T,CMP,AUG>* N, F& fn)
+{
+    std::vector<TreeNode<T,CMP,AUG>*> stack;
+    TreeNode<T,CMP,AUG>* cur = N;
+    while ((cur != nullptr && cur != endNode) || !stack.empty())
+    {
+        //go as far left as possible
+        while (cur != nullptr && cur != endNode)
+        {
+            stack.push_back(cur);
+            cur = cur->left;
+        }
+        cur = stack.back();
+        stack.pop_back();
+        if (!cur->erased)
+            fn(cur->data);
+        cur = cur->right;
+    }
+}
+
+/** Definition of the run_tasks function. It starts the threads (the calling thread is one of them), and each one keeps taking the next task
+ index until none are left. If a task throws, the other threads stop taking new tasks, and the first exception is rethrown once all of them
+ have finished.
+ 
+ @param count is the number of tasks
+ @param work is called with each task index from 0 to count-1, exactly once
+ */
+template <typename T,typename CMP,typename AUG>
+template <typename Work>
+void BinarySearchTree<T,CMP,AUG>::run_tasks(std::size_t count, Work work) const
+{
+    unsigned threads = parallelThreads ? parallelThreads : std::thread::hardware_concurrency();
+    std::size_t workers = std::min<std::size_t>(threads ? threads : 1, count);
+    if (workers == 0) return;
     
-    // largest contains largest child in left subtree
+    std::atomic<std::size_t> next(0);
+    std::vector<std::exception_ptr> errors(workers);
+    auto worker = [&](std::size_t id) {
+        try
+        {
+            for (std::size_t i = next++; i < count; i = next++)
+                work(i);
+        }
+        catch (...)
+        {
+            errors[id] = std::current_exception();
+            next = count;
+        }
+    };
     
-    // Move contents of the nodes
-    to_be_removed->data = largest->data;
-    //if the parent of the largest node is the node we want to remove, re link accordingly
-    if (largest_parent == to_be_removed)
-    {
-        largest_parent->left = largest->left;
-        if(largest_parent->left!=nullptr)
-            //set parent correctly
-            largest_parent->left->parent=largest_parent;
-        //clear heap memory
-        delete largest;
-    }
-    //if the parent of the largest node is not the node we want to remove, re link accordingly
+    std::vector<std::thread> pool;
+    for (std::size_t id = 1; id < workers; ++id)
+        pool.push_back(std::thread(worker, id));
+    worker(0);
+    for (std::thread& thread : pool)
+        thread.join();
+    for (std::exception_ptr& error : errors)
+    {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+/** Definition of the rebuild function, that relinks the given nodes into a balanced tree and puts the endNode back after the largest one.
+ 
+ @param nodes are all the nodes of the tree, in order
+ */
+template <typename T,typename CMP,typename AUG>
+void BinarySearchTree<T,CMP,AUG>::rebuild(std::vector<TreeNode<T,CMP,AUG>*>& nodes)
+{
+    root = build_balanced(nodes, 0, nodes.size(), nullptr);
+    if (root == nullptr)
+    {
+        beginNode = nullptr;
+        if (endNode != nullptr)
+            endNode->parent = nullptr;
+    }
     else
     {
-        largest_parent->right = largest->left;
-        if(largest_parent->right!=nullptr)
-            //set parent correctly
-            largest_parent->right->parent=largest_parent;
-        //remove heap memory
-        delete largest;
-        
+        //the endNode goes back after the largest node
+        beginNode = nodes.front();
+        nodes.back()->right = endNode;
+        endNode->parent = nodes.back();
     }
-    
+}
+
+/** Definition of the build_balanced function, that makes the middle node of nodes[lo,hi) the root of the subtree and recursively builds its
+ left and right subtrees out of the two halves.
+ 
+ @param nodes are the nodes of the tree in order
+ @param lo is the first node of the subtree
+ @param hi is one after the last node of the subtree
+ @param parent2 is the parent of the subtree
+ @return the root of the subtree, or nullptr if it is empty
+ */
+template <typename T,typename CMP,typename AUG>
+TreeNode<T,CMP,AUG>* BinarySearchTree<T,CMP,AUG>::build_balanced(std::vector<TreeNode<T,CMP,AUG>*>& nodes, std::size_t lo, std::size_t hi, TreeNode<T,CMP,AUG>* parent2)
+{
+    if (lo >= hi) return nullptr;
+    std::size_t mid = lo + (hi - lo) / 2;
+    TreeNode<T,CMP,AUG>* N = nodes[mid];
+    N->parent = parent2;
+    N->left = build_balanced(nodes, lo, mid, N);
+    N->right = build_balanced(nodes, mid + 1, hi, N);
+    update_summary(N);
+    return N;
+}
+
+/** Definition of the size function
+ 
+ @return the number of values in the tree, not counting tombstones
+ */
+template <typename T,typename CMP,typename AUG>
+std::size_t BinarySearchTree<T,CMP,AUG>::size() const
+{
+    return treeStats.size;
+}
+
+/** Definition of the stats function
+ 
+ @return the counters the tree keeps about itself
+ */
+template <typename T,typename CMP,typename AUG>
+const TreeStats& BinarySearchTree<T,CMP,AUG>::stats() const
+{
+    return treeStats;
 }
 
 /** Definition of the smallest function that returns the smallest element of the tree.
  
- @returns integer value of the smallest value in the tree
+ @returns the smallest value in the tree
+ @throws std::out_of_range if the tree is empty
+ */
+
+template <typename T,typename CMP,typename AUG>
+T BinarySearchTree<T,CMP,AUG>::smallest()
+{
+    if (treeStats.size == 0) throw std::out_of_range("smallest() called on an empty BinarySearchTree");
+    //begin() starts at the smallest node, which is kept up to date by insert and erase
+    return *begin();
+}
+
+/** Definition of the largest function that returns the largest element of the tree.
+ 
+ @returns the largest value in the tree
+ @throws std::out_of_range if the tree is empty
  */
+template <typename T,typename CMP,typename AUG>
+T BinarySearchTree<T,CMP,AUG>::largest()
+{
+    if (treeStats.size == 0) throw std::out_of_range("largest() called on an empty BinarySearchTree");
+    //the largest node is the one the endNode hangs off, or the first value before it if that is a tombstone
+    TreeIterator<T,CMP,AUG> last = end();
+    --last;
+    return *last;
+}
 
-template <typename T,typename CMP>
-T BinarySearchTree<T,CMP>::smallest()
+/** Definition of the pop_min function that removes the smallest element of the tree and returns it. The smallest node never has a left
+ child, so it is unlinked without searching the tree. Tombstones in front of it are unlinked on the way. The node goes on the spare list
+ for later inserts.
+ 
+ @returns the value that was removed
+ @throws std::out_of_range if the tree is empty
+ */
+template <typename T,typename CMP,typename AUG>
+T BinarySearchTree<T,CMP,AUG>::pop_min()
 {
-    //have a treenode to keep track of traversal
-    TreeNode<T,CMP>* cur=root;
-    //traverse tree for the left most node
-    while(cur->left!=NULL)
+    if (treeStats.size == 0) throw std::out_of_range("pop_min() called on an empty BinarySearchTree");
+    //clear out tombstones sitting in front of the smallest value
+    while (beginNode->erased)
     {
-        cur=cur->left;
+        TreeNode<T,CMP,AUG>* tombstone = beginNode;
+        erase_node(tombstone);
+        free_node(tombstone);
     }
-    //return the data value of the smallest value
-    return cur->data;
+    TreeNode<T,CMP,AUG>* N = beginNode;
+    //relink the tree around the node first, the hash index finds it by the value it still holds
+    erase_node(N);
+    T data = std::move(N->data);
+    free_node(N);
+    return data;
 }
 
-/** Definition of the largest function that returns the largest element of the tree.
+/** Definition of the pop_max function that removes the largest element of the tree and returns it. Tombstones after it are unlinked on the way,
+ and the node goes on the spare list like in pop_min.
  
- @returns integer value of the largest value in the tree
+ @returns the value that was removed
+ @throws std::out_of_range if the tree is empty
  */
-template <typename T,typename CMP>
-T BinarySearchTree<T,CMP>::largest()
+template <typename T,typename CMP,typename AUG>
+T BinarySearchTree<T,CMP,AUG>::pop_max()
 {
-    //have a treenode to keep track of traversal
-    TreeNode<T,CMP>* cur=root;
-    //traverse tree for right most node
-    while(cur->right!=NULL)
+    if (treeStats.size == 0) throw std::out_of_range("pop_max() called on an empty BinarySearchTree");
+    //clear out tombstones sitting after the largest value
+    while (endNode->parent->erased)
     {
-        cur=cur->right;
+        TreeNode<T,CMP,AUG>* tombstone = endNode->parent;
+        erase_node(tombstone);
+        free_node(tombstone);
     }
-    //return largest value in the tree
-    return cur->data;
+    TreeNode<T,CMP,AUG>* N = endNode->parent;
+    //relink the tree around the node first, the hash index finds it by the value it still holds
+    erase_node(N);
+    T data = std::move(N->data);
+    free_node(N);
+    return data;
 }
 
 
 /** Definition of the begin() function, returns a TreeIterator to the smallest value in the tree, useful so that we can use the auto: functionality for the BST
  
- @returns a TreeIterator to the smallest value in the tree
+ @returns a TreeIterator to the smallest value in the tree, or end() if the tree is empty
  */
 
-template <typename T,typename CMP>
-TreeIterator<T,CMP> BinarySearchTree<T,CMP>::begin()
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> BinarySearchTree<T,CMP,AUG>::begin()
 {
-    //create a new tree iterator
-    TreeIterator<T,CMP> iter;
-    TreeNode<T,CMP>* cur=root;
-    //traverse tree for leftmost smallest node
-    while(cur->left!=NULL)
-    {
-        cur=cur->left;
-    }
-    //set the iterator's node to the smallest node
-    iter.node=cur;
+    //an empty tree starts at its end
+    if (root == nullptr) return end();
+    //set the iterator's node to the smallest node, stepping past it if it is a tombstone
+    TreeIterator<T,CMP,AUG> iter = iterator_at(beginNode);
+    if (beginNode->erased)
+        ++iter;
     return iter;
-    
 }
 
 /** Definition of the end() function, returns a TreeIterator to the position after the largest value in the tree, useful so that we can use the auto: functionality for the BST
  
  @returns a TreeIterator to the position to one after the largest value in the tree (the endNode)
  */
-template <typename T,typename CMP>
-TreeIterator<T,CMP> BinarySearchTree<T,CMP>::end()
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> BinarySearchTree<T,CMP,AUG>::end()
 {
     //create a new tree iterator
-    TreeIterator<T,CMP> iter;
+    TreeIterator<T,CMP,AUG> iter;
 
     //set the end iterators node to the tree's end Node
     iter.node=endNode;
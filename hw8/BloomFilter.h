@@ -0,0 +1,161 @@
+/** @file BloomFilter.h
+ @brief Contains the class declaration and definitions for BlockedBloomFilter, an approximate set of hashes.
+
+ A Bloom filter answers "definitely not added" or "maybe added" using a few bits per key. A plain Bloom filter sets k bits anywhere in its
+ bit array, so a lookup can take k cache misses. This one is blocked: the hash first picks one 64 byte block (one cache line), and all k bits
+ go into that block, so a lookup touches a single cache line. That costs a slightly higher false positive rate for the same number of bits, which
+ reset() makes up for by adding a few more bits per key.
+
+ Bits can't be taken out again, so removed keys leave stale bits behind until the filter is reset and refilled. The owner of the filter decides
+ when to do that.
+ */
+
+#ifndef BloomFilter_h
+#define BloomFilter_h
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BlockedBloomFilter
+{
+public:
+    //constructor, makes an empty filter that holds nothing
+    BlockedBloomFilter();
+    //clear the filter and size it for capacity keys at the given false positive rate
+    void reset(std::size_t capacity, double false_positive_rate);
+    //add a hash
+    void add(std::size_t hash);
+    //false if the hash was definitely never added
+    bool may_contain(std::size_t hash) const;
+    //number of keys the filter was sized for
+    std::size_t capacity() const;
+    //bytes used by the bit array
+    std::size_t memory_usage() const;
+
+private:
+    //bits in a block, one cache line
+    static const unsigned blockBits = 512;
+    //spread the bits of a hash, since std::hash of an integer is often the integer itself
+    static std::uint64_t mix(std::uint64_t x);
+    //the bit array, eight words per block
+    std::vector<std::uint64_t> words;
+    //number of blocks
+    std::size_t blockCount;
+    //bits set per key
+    unsigned hashCount;
+    //number of keys the filter was sized for
+    std::size_t keyCapacity;
+};
+
+
+/** Definition of the constructor, the empty filter has no blocks and can't be added to until reset() is called.
+ */
+inline BlockedBloomFilter::BlockedBloomFilter()
+{
+    blockCount = 0;
+    hashCount = 0;
+    keyCapacity = 0;
+}
+
+
+/** Definition of the reset function. An ideal Bloom filter needs -log2(p) / ln 2 bits per key and -log2(p) bits set per key for a false positive
+ rate p. Packing all the bits of a key into one block makes some blocks fuller than others, so 20% more bits are used to keep the rate close to p.
+
+ @param capacity is the number of keys the filter should hold at the false positive rate
+ @param false_positive_rate is the chance that may_contain says yes for a hash that was never added
+ */
+inline void BlockedBloomFilter::reset(std::size_t capacity, double false_positive_rate)
+{
+    if (false_positive_rate <= 0.0 || false_positive_rate >= 1.0)
+        false_positive_rate = 0.01;
+    double bits_per_key = 1.2 * -std::log2(false_positive_rate) / std::log(2.0);
+    std::size_t bits = static_cast<std::size_t>(bits_per_key * (capacity > 0 ? capacity : 1)) + 1;
+
+    keyCapacity = capacity;
+    blockCount = (bits + blockBits - 1) / blockBits;
+    hashCount = static_cast<unsigned>(std::lround(-std::log2(false_positive_rate)));
+    if (hashCount < 1) hashCount = 1;
+    if (hashCount > 16) hashCount = 16;
+    words.assign(blockCount * (blockBits / 64), 0);
+}
+
+
+/** Definition of the add function, that sets the bits of a hash in its block.
+
+ @param hash of the key to add
+ */
+inline void BlockedBloomFilter::add(std::size_t hash)
+{
+    if (blockCount == 0) return;
+    std::uint64_t h = mix(hash);
+    std::uint64_t* block = &words[(h >> 32) % blockCount * (blockBits / 64)];
+    //double hashing picks the bits inside the block
+    std::uint32_t h1 = static_cast<std::uint32_t>(h);
+    std::uint32_t h2 = static_cast<std::uint32_t>(mix(h) >> 32) | 1;
+    for (unsigned i = 0; i < hashCount; ++i)
+    {
+        unsigned bit = (h1 + i * h2) % blockBits;
+        block[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    }
+}
+
+
+/** Definition of the may_contain function, that checks the bits of a hash in its block.
+
+ @param hash of the key to look up
+ @return false if the hash was definitely never added since the last reset, true if it may have been
+ */
+inline bool BlockedBloomFilter::may_contain(std::size_t hash) const
+{
+    //a filter that was never sized can't rule anything out
+    if (blockCount == 0) return true;
+    std::uint64_t h = mix(hash);
+    const std::uint64_t* block = &words[(h >> 32) % blockCount * (blockBits / 64)];
+    std::uint32_t h1 = static_cast<std::uint32_t>(h);
+    std::uint32_t h2 = static_cast<std::uint32_t>(mix(h) >> 32) | 1;
+    for (unsigned i = 0; i < hashCount; ++i)
+    {
+        unsigned bit = (h1 + i * h2) % blockBits;
+        if ((block[bit / 64] & (std::uint64_t(1) << (bit % 64))) == 0) return false;
+    }
+    return true;
+}
+
+
+/** Definition of the capacity function
+
+ @return the number of keys the filter was sized for by the last reset
+ */
+inline std::size_t BlockedBloomFilter::capacity() const
+{
+    return keyCapacity;
+}
+
+
+/** Definition of the memory_usage function
+
+ @return the number of bytes in the bit array
+ */
+inline std::size_t BlockedBloomFilter::memory_usage() const
+{
+    return words.size() * sizeof(std::uint64_t);
+}
+
+
+/** Definition of the mix function, the 64 bit finaliser of MurmurHash3.
+
+ @param x is the value to mix
+ @return x with every bit depending on every input bit
+ */
+inline std::uint64_t BlockedBloomFilter::mix(std::uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+#endif /* BloomFilter_h */
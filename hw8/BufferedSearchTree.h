@@ -0,0 +1,373 @@
+/** @file BufferedSearchTree.h
+ @brief Contains the class declarations and definitions for a BufferedSearchTree templated class, a write-optimised wrapper around BinarySearchTree.
+
+ Inserts are appended to a small unsorted buffer, which costs no comparisons and no allocation. Once the buffer holds flush_threshold values
+ it is sorted into a run. Runs are kept in tiers like the digits of a binary counter: a new run is merged with the run before it while that one
+ is no bigger, so there are only O(log n) runs and every merge is a sequential pass. Once the runs hold as many values as the tree, they are
+ merged into the tree with BinarySearchTree::merge_sorted, which rebuilds it into balanced shape in one linear pass. Since the tree at least doubles
+ between those merges, each value costs amortised O(1) tree work.
+
+ Reads look through the buffer, then each run from newest to oldest, and then the tree. Iterating first merges everything into the tree,
+ so it always sees every value. As in BinarySearchTree, inserting a value that is already there keeps the first copy.
+ erase works like lazy erase in BinarySearchTree: values in runs are only marked, and the next merge that passes over them drops them, so
+ an erase costs a binary search per run instead of shifting the rest of each run.
+
+ stats() counts every time a value is written into the buffer, into a run and into the tree, and write_amplification() reports how many
+ writes each inserted value cost.
+ */
+
+#ifndef BufferedSearchTree_h
+#define BufferedSearchTree_h
+#include "BinarySearchTree.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**@struct BufferStats
+	@brief Counters a BufferedSearchTree keeps about its writes.
+ */
+struct BufferStats
+{
+    //values passed to insert
+    std::size_t inserts;
+    //number of times the buffer was sorted into a run
+    std::size_t flushes;
+    //number of times two runs were merged
+    std::size_t run_merges;
+    //number of times the runs were merged into the tree
+    std::size_t tree_merges;
+    //values written into the buffer
+    std::size_t buffer_writes;
+    //values written into runs, by flushes and run merges
+    std::size_t run_writes;
+    //values written into the tree
+    std::size_t tree_writes;
+};
+
+
+template <typename T,typename CMP=std::less<T>>
+class BufferedSearchTree
+{
+public:
+    //constructor, the buffer is sorted into a run once it holds flush_threshold values
+    explicit BufferedSearchTree(std::size_t flush_threshold = 1024);
+    //add element to the buffer, flushing it if it is full
+    void insert(T data);
+    //remove element from the buffer, the runs and the tree
+    void erase(const T& data);
+    //check the buffer, the runs and then the tree for an element
+    bool contains(const T& data);
+    //sort the buffer into a run
+    void flush();
+    //flush the buffer and merge all runs into the tree
+    void merge_all();
+    //change how many values the buffer holds before it is flushed
+    void set_flush_threshold(std::size_t flush_threshold);
+    //access iterators over all elements, merging everything into the tree first
+    TreeIterator<T,CMP> begin();
+    TreeIterator<T,CMP> end();
+    //the tree holding everything merged so far
+    BinarySearchTree<T,CMP>& tree();
+    //counters about writes
+    const BufferStats& stats() const;
+    //writes per inserted value
+    double write_amplification() const;
+
+private:
+    //sort the buffer into the newest run
+    void push_run();
+    //merge the newest run into the one before it
+    void merge_last_runs();
+    //true if a and b are equal according to the comparator
+    bool equal(const T& a, const T& b) const;
+    //values inserted since the last flush, in insertion order
+    std::vector<T> buffer;
+    //sorted runs without repeats, oldest (and largest) first
+    std::vector<std::vector<T>> runs;
+    //erased values of each run, erasedMarks[i][j] is true if runs[i][j] was erased
+    std::vector<std::vector<bool>> erasedMarks;
+    //number of values held by all runs, erased ones included until a merge drops them
+    std::size_t runValues;
+    //number of values at which the buffer is flushed
+    std::size_t flushThreshold;
+    //tree holding the merged values
+    BinarySearchTree<T,CMP> merged;
+    //to compare data based on specified comparator
+    CMP isless;
+    //counters reported by stats()
+    BufferStats bufferStats;
+};
+
+
+/** Definition of the constructor, that sets up an empty tree and buffer.
+
+ @param flush_threshold is the number of values the buffer holds before it is sorted into a run
+ */
+template <typename T,typename CMP>
+BufferedSearchTree<T,CMP>::BufferedSearchTree(std::size_t flush_threshold)
+{
+    flushThreshold = flush_threshold > 0 ? flush_threshold : 1;
+    buffer.reserve(flushThreshold);
+    runValues = 0;
+    bufferStats = BufferStats();
+}
+
+
+/** Definition of the insert function, that appends the value to the buffer and flushes the buffer once it is full.
+
+ @param value you want to insert
+ */
+template <typename T,typename CMP>
+void BufferedSearchTree<T,CMP>::insert(T data)
+{
+    buffer.push_back(std::move(data));
+    ++bufferStats.inserts;
+    ++bufferStats.buffer_writes;
+    if (buffer.size() >= flushThreshold)
+        flush();
+}
+
+
+/** Definition of the erase function, that drops the value from the buffer and the tree and marks it as erased in every run. The buffer is
+ never bigger than flush_threshold, so it is filtered right away; runs can be as big as the tree, so their copies are left for the next
+ merge to drop.
+
+ @param value you want to remove
+ */
+template <typename T,typename CMP>
+void BufferedSearchTree<T,CMP>::erase(const T& data)
+{
+    //remove it from the buffer so a later flush does not bring it back
+    buffer.erase(std::remove_if(buffer.begin(), buffer.end(), [&](const T& x) { return equal(x, data); }), buffer.end());
+    for (std::size_t r = 0; r < runs.size(); ++r)
+    {
+        typename std::vector<T>::iterator it = std::lower_bound(runs[r].begin(), runs[r].end(), data, isless);
+        if (it != runs[r].end() && !isless(data, *it))
+            erasedMarks[r][it - runs[r].begin()] = true;
+    }
+    merged.erase(data);
+}
+
+
+/** Definition of the contains function, that scans the buffer, binary searches each run and then searches the tree.
+
+ @param value you want to look up
+ @return true if the value was inserted and not erased
+ */
+template <typename T,typename CMP>
+bool BufferedSearchTree<T,CMP>::contains(const T& data)
+{
+    //newest values are at the back of the buffer
+    for (auto it = buffer.rbegin(); it != buffer.rend(); ++it)
+    {
+        if (equal(*it, data)) return true;
+    }
+    for (std::size_t r = runs.size(); r-- > 0;)
+    {
+        typename std::vector<T>::const_iterator it = std::lower_bound(runs[r].cbegin(), runs[r].cend(), data, isless);
+        if (it != runs[r].cend() && !isless(data, *it) && !erasedMarks[r][it - runs[r].cbegin()]) return true;
+    }
+    return merged.find(data) != merged.end();
+}
+
+
+/** Definition of the flush function. The buffer is stable sorted, so equal values keep insertion order and the first one wins like a
+ plain insert, and becomes the newest run. Runs are then merged while the one before the newest is no bigger, and once the runs hold as many
+ values as the tree they are all merged into it.
+ */
+template <typename T,typename CMP>
+void BufferedSearchTree<T,CMP>::flush()
+{
+    if (buffer.empty()) return;
+    push_run();
+
+    //carry like a binary counter, so run sizes at least double from newest to oldest
+    while (runs.size() >= 2 && runs[runs.size() - 2].size() <= runs.back().size())
+        merge_last_runs();
+
+    if (runValues >= merged.size())
+        merge_all();
+}
+
+
+/** Definition of the merge_all function, that flushes the buffer, merges all runs into one and merges that into the tree.
+ */
+template <typename T,typename CMP>
+void BufferedSearchTree<T,CMP>::merge_all()
+{
+    if (!buffer.empty())
+        push_run();
+    if (runs.empty()) return;
+
+    while (runs.size() >= 2)
+        merge_last_runs();
+    //a single run was never merged, so drop its erased values here
+    std::vector<T>& last = runs.back();
+    std::vector<bool>& marks = erasedMarks.back();
+    if (std::find(marks.begin(), marks.end(), true) != marks.end())
+    {
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < last.size(); ++i)
+        {
+            if (!marks[i])
+                last[kept++] = std::move(last[i]);
+        }
+        last.erase(last.begin() + kept, last.end());
+    }
+    //merge_sorted drops repeats and keeps the tree's copy of values it already has
+    bufferStats.tree_writes += runs.back().size();
+    ++bufferStats.tree_merges;
+    merged.merge_sorted(runs.back().begin(), runs.back().end());
+    runs.clear();
+    erasedMarks.clear();
+    runValues = 0;
+}
+
+
+/** Definition of the push_run function, that sorts the buffer, drops repeats and makes it the newest run. A fresh buffer takes its place.
+ */
+template <typename T,typename CMP>
+void BufferedSearchTree<T,CMP>::push_run()
+{
+    std::stable_sort(buffer.begin(), buffer.end(), isless);
+    buffer.erase(std::unique(buffer.begin(), buffer.end(), [&](const T& a, const T& b) { return equal(a, b); }), buffer.end());
+
+    bufferStats.run_writes += buffer.size();
+    runValues += buffer.size();
+    ++bufferStats.flushes;
+    runs.push_back(std::vector<T>());
+    runs.back().swap(buffer);
+    erasedMarks.push_back(std::vector<bool>(runs.back().size(), false));
+    buffer.reserve(flushThreshold);
+}
+
+
+/** Definition of the merge_last_runs function. The merge takes from the older run first on ties, and std::unique keeps the first of equal
+ values, so the older copy of a repeated value wins. Erased values are skipped, so a value inserted again after it was erased survives
+ the merge even though its older copy comes first.
+ */
+template <typename T,typename CMP>
+void BufferedSearchTree<T,CMP>::merge_last_runs()
+{
+    std::vector<T>& older = runs[runs.size() - 2];
+    std::vector<T>& newer = runs.back();
+    const std::vector<bool>& olderMarks = erasedMarks[erasedMarks.size() - 2];
+    const std::vector<bool>& newerMarks = erasedMarks.back();
+    std::vector<T> out;
+    out.reserve(older.size() + newer.size());
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < older.size() || j < newer.size())
+    {
+        //like std::merge, take the older value unless the newer one is smaller
+        if (j == newer.size() || (i < older.size() && !isless(newer[j], older[i])))
+        {
+            if (!olderMarks[i])
+                out.push_back(std::move(older[i]));
+            ++i;
+        }
+        else
+        {
+            if (!newerMarks[j])
+                out.push_back(std::move(newer[j]));
+            ++j;
+        }
+    }
+    out.erase(std::unique(out.begin(), out.end(), [&](const T& a, const T& b) { return equal(a, b); }), out.end());
+
+    runValues -= older.size() + newer.size();
+    runValues += out.size();
+    bufferStats.run_writes += out.size();
+    ++bufferStats.run_merges;
+    runs.pop_back();
+    runs.back().swap(out);
+    erasedMarks.pop_back();
+    erasedMarks.back().assign(runs.back().size(), false);
+}
+
+
+/** Definition of the set_flush_threshold function, that changes the buffer size and flushes right away if the buffer is already over it.
+
+ @param flush_threshold is the number of values the buffer holds before it is sorted into a run
+ */
+template <typename T,typename CMP>
+void BufferedSearchTree<T,CMP>::set_flush_threshold(std::size_t flush_threshold)
+{
+    flushThreshold = flush_threshold > 0 ? flush_threshold : 1;
+    buffer.reserve(flushThreshold);
+    if (buffer.size() >= flushThreshold)
+        flush();
+}
+
+
+/** Definition of the begin() function, that merges everything into the tree and returns an iterator to the smallest value
+
+ @return TreeIterator to the smallest value
+ */
+template <typename T,typename CMP>
+TreeIterator<T,CMP> BufferedSearchTree<T,CMP>::begin()
+{
+    merge_all();
+    return merged.begin();
+}
+
+
+/** Definition of the end() function, returns an iterator to the position after the largest value
+
+ @return TreeIterator to one after the largest value
+ */
+template <typename T,typename CMP>
+TreeIterator<T,CMP> BufferedSearchTree<T,CMP>::end()
+{
+    return merged.end();
+}
+
+
+/** Definition of the tree function
+
+ @return the tree holding every value merged so far
+ */
+template <typename T,typename CMP>
+BinarySearchTree<T,CMP>& BufferedSearchTree<T,CMP>::tree()
+{
+    return merged;
+}
+
+
+/** Definition of the stats function
+
+ @return counters about inserts, flushes, merges and writes
+ */
+template <typename T,typename CMP>
+const BufferStats& BufferedSearchTree<T,CMP>::stats() const
+{
+    return bufferStats;
+}
+
+
+/** Definition of the write_amplification function. Every value is written once into the buffer, once into a run, once more for every run
+ merge it takes part in, and once into the tree.
+
+ @return the number of value writes per inserted value
+ */
+template <typename T,typename CMP>
+double BufferedSearchTree<T,CMP>::write_amplification() const
+{
+    if (bufferStats.inserts == 0) return 0.0;
+    return static_cast<double>(bufferStats.buffer_writes + bufferStats.run_writes + bufferStats.tree_writes) / bufferStats.inserts;
+}
+
+
+/** Definition of the equal function, two values are equal if neither is less than the other.
+
+ @return true if a and b are equal according to the comparator
+ */
+template <typename T,typename CMP>
+bool BufferedSearchTree<T,CMP>::equal(const T& a, const T& b) const
+{
+    return !isless(a, b) && !isless(b, a);
+}
+
+
+#endif /* BufferedSearchTree_h */
@@ -0,0 +1,372 @@
+/** @file HashIndex.h
+ @brief Contains the class declarations and definitions for a HashIndex templated class, an open addressing hash table from values to the
+ TreeNodes holding them.
+
+ BinarySearchTree::set_hash_index keeps one of these next to the tree, so find and contains answer exact matches with a hash probe instead
+ of a walk down the tree. The table is laid out like a Swiss table. Every slot holds a TreeNode pointer and has one control byte, which is
+ either empty, deleted, or 7 bits of the value's hash. A lookup loads the control bytes of 16 slots at once and compares them all with the
+ 7 bit tag (one SSE2 compare where the compiler has SSE2, a plain loop otherwise). Only slots whose tag matches are compared with the
+ comparator, which almost always means one, and a group with an empty slot ends the search. Erasing leaves a deleted marker so later probes
+ keep going, and the markers are cleared when the table is rebuilt.
+
+ Values are hashed with a function the tree hands in (TreeHash<T,CMP>), so values that are equal under CMP find the same slot.
+ */
+
+#ifndef HashIndex_h
+#define HashIndex_h
+#include "TreeNode.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HASH_INDEX_SSE2 1
+#endif
+
+template <typename T,typename CMP,typename AUG>
+class HashIndex
+{
+public:
+    //constructor for an index that is off
+    HashIndex();
+    //turn the index on, empty, hashing with hash_fn and sized for expected values
+    void reset(std::size_t (*hash_fn)(const T&), std::size_t expected);
+    //turn the index off and give back its memory
+    void clear();
+    //true if the index is on
+    bool enabled() const;
+    //node holding data, nullptr if there is none
+    TreeNode<T,CMP,AUG>* find(const T& data) const;
+    //add a node whose value is not in the index yet
+    void insert(TreeNode<T,CMP,AUG>* N);
+    //take a node out of the index, before its value is moved or changed
+    void erase(TreeNode<T,CMP,AUG>* N);
+    //bytes used by the table
+    std::size_t memory_usage() const;
+
+private:
+    //slots compared at once
+    static constexpr std::size_t groupWidth = 16;
+    //control byte of a slot that was never used
+    static constexpr std::int8_t emptySlot = -128;
+    //control byte of a slot whose node was erased
+    static constexpr std::int8_t deletedSlot = -2;
+    //bit i is set if control byte i of the group at ctrl equals tag
+    static unsigned match(const std::int8_t* ctrl, std::int8_t tag);
+    //bit i is set if slot i of the group at ctrl is empty or deleted
+    static unsigned match_free(const std::int8_t* ctrl);
+    //spread the bits of a hash, since std::hash of an int is often the int itself
+    static std::size_t mix(std::size_t hash);
+    //index of the lowest set bit
+    static unsigned lowest_bit(unsigned mask);
+    //set the control byte of a slot, and its copy past the end of the table
+    void set_ctrl(std::size_t slot, std::int8_t tag);
+    //put a node into the first free slot of its probe sequence
+    void place(TreeNode<T,CMP,AUG>* N, std::size_t hash);
+    //move every node into a new table with room for capacity slots
+    void rehash(std::size_t capacity);
+    //control bytes, followed by copies of the first groupWidth - 1 so a group starting near the end can be loaded in one go
+    std::vector<std::int8_t> ctrl;
+    //node of each slot
+    std::vector<TreeNode<T,CMP,AUG>*> slots;
+    //number of slots minus one, the table size is a power of two
+    std::size_t mask;
+    //nodes in the index
+    std::size_t count;
+    //nodes that can still go into empty slots before the table is rebuilt
+    std::size_t growthLeft;
+    //hash function of the values, nullptr when the index is off
+    std::size_t (*hashFn)(const T&);
+    //to compare data based on specified comparator
+    CMP isless;
+};
+
+
+/** Definition of the constructor
+ */
+template <typename T,typename CMP,typename AUG>
+HashIndex<T,CMP,AUG>::HashIndex()
+{
+    mask = 0;
+    count = 0;
+    growthLeft = 0;
+    hashFn = nullptr;
+}
+
+
+/** Definition of the reset function. The table keeps at most 7/8 of its slots full, so it gets the smallest power of two size (at least one
+ group) with that much room for expected values.
+
+ @param hash_fn hashes a value consistently with CMP
+ @param expected is the number of values about to be inserted
+ */
+template <typename T,typename CMP,typename AUG>
+void HashIndex<T,CMP,AUG>::reset(std::size_t (*hash_fn)(const T&), std::size_t expected)
+{
+    hashFn = hash_fn;
+    std::size_t capacity = groupWidth;
+    while (capacity / 8 * 7 < expected)
+        capacity *= 2;
+    ctrl.assign(capacity + groupWidth - 1, emptySlot);
+    slots.assign(capacity, nullptr);
+    mask = capacity - 1;
+    count = 0;
+    growthLeft = capacity / 8 * 7;
+}
+
+
+/** Definition of the clear function
+ */
+template <typename T,typename CMP,typename AUG>
+void HashIndex<T,CMP,AUG>::clear()
+{
+    hashFn = nullptr;
+    std::vector<std::int8_t>().swap(ctrl);
+    std::vector<TreeNode<T,CMP,AUG>*>().swap(slots);
+    mask = 0;
+    count = 0;
+    growthLeft = 0;
+}
+
+
+/** Definition of the enabled function
+
+ @return true if the index is on
+ */
+template <typename T,typename CMP,typename AUG>
+bool HashIndex<T,CMP,AUG>::enabled() const
+{
+    return hashFn != nullptr;
+}
+
+
+/** Definition of the find function. The high bits of the hash pick where the probe starts and the low 7 bits are the tag. Groups are probed at
+ growing distances (16, 32, 48 slots further, ...), which visits every group of a power of two table.
+
+ @param value you want to look up
+ @return the node holding it, or nullptr if it is not in the index
+ */
+template <typename T,typename CMP,typename AUG>
+TreeNode<T,CMP,AUG>* HashIndex<T,CMP,AUG>::find(const T& data) const
+{
+    std::size_t hash = mix(hashFn(data));
+    std::int8_t tag = static_cast<std::int8_t>(hash & 0x7F);
+    std::size_t pos = (hash >> 7) & mask;
+    for (std::size_t step = groupWidth; ; step += groupWidth)
+    {
+        const std::int8_t* group = ctrl.data() + pos;
+        for (unsigned hits = match(group, tag); hits != 0; hits &= hits - 1)
+        {
+            TreeNode<T,CMP,AUG>* N = slots[(pos + lowest_bit(hits)) & mask];
+            if (!isless(N->data, data) && !isless(data, N->data))
+                return N;
+        }
+        //a value is never placed past an empty slot of its probe sequence
+        if (match(group, emptySlot) != 0)
+            return nullptr;
+        pos = (pos + step) & mask;
+    }
+}
+
+
+/** Definition of the insert function. If the table has no room left it is rebuilt first, at the same size if deleted slots take up the room
+ and at twice the size if not.
+
+ @param N is a node whose value is not in the index
+ */
+template <typename T,typename CMP,typename AUG>
+void HashIndex<T,CMP,AUG>::insert(TreeNode<T,CMP,AUG>* N)
+{
+    if (growthLeft == 0)
+        rehash(count * 2 < (mask + 1) / 8 * 7 ? mask + 1 : 2 * (mask + 1));
+    place(N, mix(hashFn(N->data)));
+    ++count;
+}
+
+
+/** Definition of the erase function. The probe starts from the hash of N's value and the slot is matched by pointer, so N must still hold
+ the value it was inserted with; take it out before moving or overwriting its data.
+
+ @param N is a node in the index, holding the value it was inserted with
+ */
+template <typename T,typename CMP,typename AUG>
+void HashIndex<T,CMP,AUG>::erase(TreeNode<T,CMP,AUG>* N)
+{
+    std::size_t hash = mix(hashFn(N->data));
+    std::int8_t tag = static_cast<std::int8_t>(hash & 0x7F);
+    std::size_t pos = (hash >> 7) & mask;
+    for (std::size_t step = groupWidth; ; step += groupWidth)
+    {
+        const std::int8_t* group = ctrl.data() + pos;
+        for (unsigned hits = match(group, tag); hits != 0; hits &= hits - 1)
+        {
+            std::size_t slot = (pos + lowest_bit(hits)) & mask;
+            if (slots[slot] == N)
+            {
+                set_ctrl(slot, deletedSlot);
+                slots[slot] = nullptr;
+                --count;
+                return;
+            }
+        }
+        if (match(group, emptySlot) != 0)
+            return;
+        pos = (pos + step) & mask;
+    }
+}
+
+
+/** Definition of the memory_usage function
+
+ @return bytes used by the control bytes and the slots
+ */
+template <typename T,typename CMP,typename AUG>
+std::size_t HashIndex<T,CMP,AUG>::memory_usage() const
+{
+    return ctrl.capacity() + slots.capacity() * sizeof(TreeNode<T,CMP,AUG>*);
+}
+
+
+/** Definition of the match function
+
+ @param ctrl points at the control bytes of 16 slots
+ @param tag is the control byte looked for
+ @return a mask with bit i set if control byte i equals tag
+ */
+template <typename T,typename CMP,typename AUG>
+unsigned HashIndex<T,CMP,AUG>::match(const std::int8_t* ctrl, std::int8_t tag)
+{
+#ifdef HASH_INDEX_SSE2
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag))));
+#else
+    unsigned hits = 0;
+    for (unsigned i = 0; i < groupWidth; ++i)
+        hits |= static_cast<unsigned>(ctrl[i] == tag) << i;
+    return hits;
+#endif
+}
+
+
+/** Definition of the match_free function. Empty and deleted are the only negative control bytes besides none, and tags are 0 to 127, so a
+ slot is free exactly when its control byte is negative.
+
+ @param ctrl points at the control bytes of 16 slots
+ @return a mask with bit i set if slot i is empty or deleted
+ */
+template <typename T,typename CMP,typename AUG>
+unsigned HashIndex<T,CMP,AUG>::match_free(const std::int8_t* ctrl)
+{
+#ifdef HASH_INDEX_SSE2
+    //movemask collects the sign bit of every byte
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))));
+#else
+    unsigned hits = 0;
+    for (unsigned i = 0; i < groupWidth; ++i)
+        hits |= static_cast<unsigned>(ctrl[i] < 0) << i;
+    return hits;
+#endif
+}
+
+
+/** Definition of the mix function. The multiply carries every bit of the hash up into the high bits, and the shift brings them back down
+ to the low bits the slot and tag are taken from.
+
+ @param hash is the hash of a value
+ @return the mixed hash
+ */
+template <typename T,typename CMP,typename AUG>
+std::size_t HashIndex<T,CMP,AUG>::mix(std::size_t hash)
+{
+    std::uint64_t h = static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<std::size_t>(h ^ (h >> 29));
+}
+
+
+/** Definition of the lowest_bit function
+
+ @param mask is not 0
+ @return the index of its lowest set bit
+ */
+template <typename T,typename CMP,typename AUG>
+unsigned HashIndex<T,CMP,AUG>::lowest_bit(unsigned mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned bit = 0;
+    while (!(mask & 1u))
+    {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+
+/** Definition of the set_ctrl function. The first groupWidth - 1 control bytes are copied past the end of the table, so the copy is updated
+ too.
+
+ @param slot is the index of the slot
+ @param tag is its new control byte
+ */
+template <typename T,typename CMP,typename AUG>
+void HashIndex<T,CMP,AUG>::set_ctrl(std::size_t slot, std::int8_t tag)
+{
+    ctrl[slot] = tag;
+    if (slot < groupWidth - 1)
+        ctrl[mask + 1 + slot] = tag;
+}
+
+
+/** Definition of the place function
+
+ @param N is the node to put in the table
+ @param hash is the hash of its value
+ */
+template <typename T,typename CMP,typename AUG>
+void HashIndex<T,CMP,AUG>::place(TreeNode<T,CMP,AUG>* N, std::size_t hash)
+{
+    std::size_t pos = (hash >> 7) & mask;
+    for (std::size_t step = groupWidth; ; step += groupWidth)
+    {
+        unsigned free = match_free(ctrl.data() + pos);
+        if (free != 0)
+        {
+            std::size_t slot = (pos + lowest_bit(free)) & mask;
+            //reusing a deleted slot does not use up any room
+            if (ctrl[slot] == emptySlot)
+                --growthLeft;
+            set_ctrl(slot, static_cast<std::int8_t>(hash & 0x7F));
+            slots[slot] = N;
+            return;
+        }
+        pos = (pos + step) & mask;
+    }
+}
+
+
+/** Definition of the rehash function, which also clears every deleted marker.
+
+ @param capacity is the new number of slots, a power of two
+ */
+template <typename T,typename CMP,typename AUG>
+void HashIndex<T,CMP,AUG>::rehash(std::size_t capacity)
+{
+    std::vector<TreeNode<T,CMP,AUG>*> nodes;
+    nodes.reserve(count);
+    for (TreeNode<T,CMP,AUG>* N : slots)
+    {
+        if (N != nullptr)
+            nodes.push_back(N);
+    }
+    ctrl.assign(capacity + groupWidth - 1, emptySlot);
+    slots.assign(capacity, nullptr);
+    mask = capacity - 1;
+    growthLeft = capacity / 8 * 7;
+    for (TreeNode<T,CMP,AUG>* N : nodes)
+        place(N, mix(hashFn(N->data)));
+}
+
+#endif /* HashIndex_h */
@@ -0,0 +1,1360 @@
+/** @file PagedSearchTree.h
+ @brief Contains the class declarations and definitions for a PagedSearchTree templated class, a B+ tree kept in a file for sets larger than RAM.
+
+ The tree lives in one file of fixed 4 KiB pages. Page 0 is the file header. Every other page is an internal page (keys and child page numbers),
+ a leaf page (keys only) or a free page waiting to be reused. Values are only stored in leaves, and the leaves are chained both ways in order, so a
+ scan walks the file leaf by leaf without going back up the tree. Values are copied in and out of pages as raw bytes, so T has to be trivially
+ copyable (int, Point2D and so on).
+
+ Only a bounded number of pages are held in memory. The page cache gets a budget in bytes and evicts with the CLOCK algorithm: every page has a
+ referenced bit that is set when it is used and cleared as the clock hand passes, and the hand evicts the first unpinned page whose bit is clear.
+
+ flush() is crash safe, using a rollback journal next to the file (the path + "-journal"). Before a page that is part of the last flushed state is
+ overwritten, its old contents are appended to the journal and the journal is synced. flush() writes every dirty page and the header, syncs the
+ file, and then deletes the journal, which is the moment the new state becomes the one on disk. If the process dies before that, opening the
+ tree again finds the journal, copies the old pages back and cuts off pages added since, which brings back the last flushed state.
+
+ Erase frees a page only when it becomes empty and does not merge half empty neighbours, like many disk B-trees, since merging costs more writes
+ than the space it gives back. Iterators hold a page number and a position and read the value through the cache, so any insert or erase makes
+ them invalid.
+ */
+
+#ifndef PagedSearchTree_h
+#define PagedSearchTree_h
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**@struct PageStats
+	@brief Counters a PagedSearchTree keeps about its page cache and file.
+ */
+struct PageStats
+{
+    //pages read from the file
+    std::size_t page_reads;
+    //pages written to the file
+    std::size_t page_writes;
+    //page lookups the cache answered
+    std::size_t cache_hits;
+    //page lookups that had to read the file
+    std::size_t cache_misses;
+    //pages dropped from the cache to make room
+    std::size_t evictions;
+    //old pages copied into the journal before being overwritten
+    std::size_t journal_writes;
+    //number of times flush() wrote out the tree
+    std::size_t flushes;
+};
+
+
+template <typename T,typename CMP=std::less<T>>
+class PagedSearchTree
+{
+    static_assert(std::is_trivially_copyable<T>::value, "PagedSearchTree stores values as raw bytes, so T has to be trivially copyable");
+
+public:
+    class iterator;
+    //bytes in a page
+    static constexpr std::size_t page_size = 4096;
+
+    //constructor, opens or creates the file at path, rolling back a flush that did not finish, and caches up to cache_bytes of pages
+    explicit PagedSearchTree(const std::string& path, std::size_t cache_bytes = std::size_t(64) << 20);
+    //the tree owns its file, so it can't be copied
+    PagedSearchTree(const PagedSearchTree&) = delete;
+    PagedSearchTree& operator=(const PagedSearchTree&) = delete;
+    //destructor, flushes and closes the file
+    ~PagedSearchTree();
+    //insert element into tree
+    void insert(const T& data);
+    //remove element
+    void erase(const T& data);
+    //find element, returns end() if it is not in the tree
+    iterator find(const T& data);
+    //check whether data is in the tree
+    bool contains(const T& data);
+    //find the first element not less than data, returns end() if there is none
+    iterator lower_bound(const T& data);
+    //access iterators to the smallest value and one after the largest value
+    iterator begin();
+    iterator end();
+    //number of values in the tree
+    std::size_t size() const;
+    //write every change to the file and make it the state a crash rolls back to
+    void flush();
+    //counters about the cache and the file
+    const PageStats& stats() const;
+
+private:
+    //layout of page 0
+    struct FileHeader
+    {
+        std::uint64_t magic;
+        std::uint32_t page_bytes;
+        std::uint32_t value_bytes;
+        std::uint64_t root;
+        std::uint64_t first_leaf;
+        std::uint64_t last_leaf;
+        std::uint64_t page_count;
+        std::uint64_t free_list;
+        std::uint64_t size;
+    };
+    //layout at the start of every tree page, prev and next chain the leaves
+    struct PageHeader
+    {
+        std::uint32_t leaf;
+        std::uint32_t count;
+        std::uint64_t prev;
+        std::uint64_t next;
+    };
+    //a cache slot, page 0 means the slot is empty since the header page is never cached
+    struct Frame
+    {
+        std::uint64_t page;
+        unsigned pins;
+        bool dirty;
+        bool referenced;
+    };
+    //keys in a full leaf page
+    static constexpr std::size_t leaf_capacity = (page_size - sizeof(PageHeader)) / sizeof(T);
+    //keys in a full internal page, which also holds one more child page number than keys
+    static constexpr std::size_t internal_capacity = (page_size - sizeof(PageHeader) - 8) / (sizeof(T) + 8);
+    static_assert(internal_capacity >= 3, "PagedSearchTree needs room for at least three values in a page");
+
+    //read the header at the start of a page
+    static PageHeader header_of(const char* page);
+    //write the header at the start of a page
+    static void set_header(char* page, const PageHeader& header);
+    //key i of a page
+    static T key_at(const char* page, std::size_t i);
+    //set key i of a page
+    static void set_key(char* page, std::size_t i, const T& key);
+    //child page number i of an internal page
+    static std::uint64_t child_at(const char* page, std::size_t i);
+    //set child page number i of an internal page
+    static void set_child(char* page, std::size_t i, std::uint64_t child);
+    //index of the first key of a page not less than data
+    std::size_t key_lower_bound(const char* page, std::size_t count, const T& data) const;
+    //walk down to the leaf that holds data, recording each internal page and the child taken if path is given
+    std::uint64_t descend(const T& data, std::vector<std::pair<std::uint64_t,std::size_t>>* path);
+    //add a separator key and the page right of it to the parents on path, splitting them as needed
+    void insert_separator(std::vector<std::pair<std::uint64_t,std::size_t>>& path, T key, std::uint64_t right);
+    //take the child an emptied page was at out of the parents on path, freeing parents that empty too
+    void remove_child(std::vector<std::pair<std::uint64_t,std::size_t>>& path);
+    //create an iterator at a position, moving on to the next leaf if it is past the end of its leaf
+    iterator iterator_at(std::uint64_t leaf, std::size_t index);
+    //get a page into the cache and pin it there, returning its frame
+    std::size_t pin(std::uint64_t page);
+    //make a new zeroed page, reusing a free one if there is any, and pin it
+    std::size_t pin_new(std::uint64_t& page);
+    //let the cache evict a frame again
+    void unpin(std::size_t frame);
+    //bytes of the page in a frame
+    char* frame_data(std::size_t frame);
+    //note that a frame has to be written back
+    void mark_dirty(std::size_t frame);
+    //put a page on the free list
+    void free_page(std::uint64_t page);
+    //find a frame to load a page into, evicting with the clock
+    std::size_t free_frame();
+    //write a frame back to the file, journaling the old page first if needed
+    void write_page(std::size_t frame);
+    //copy the old contents of a page into the journal
+    void journal_page(std::uint64_t page);
+    //make the journal durable before pages it covers are overwritten
+    void sync_journal();
+    //put back the pages saved in a journal left by a crash
+    void recover();
+    //read a page of the file
+    void read_raw(std::uint64_t page, char* out);
+    //write a page of the file
+    void write_raw(std::uint64_t page, const char* data);
+    //sync the directory holding the file, so creating or deleting the journal is durable
+    void sync_directory();
+    //checksum of a journal record
+    static std::uint64_t checksum(std::uint64_t page, const char* data);
+
+    //path of the file
+    std::string filePath;
+    //open file
+    int fd;
+    //open journal, -1 if there is none
+    int journalFd;
+    //true if the journal has records that were not synced yet
+    bool journalUnsynced;
+    //header as it is now, written to page 0 by flush()
+    FileHeader meta;
+    //true if meta changed since the last flush
+    bool metaDirty;
+    //number of pages of the last flushed state, only those need journaling
+    std::uint64_t flushedPages;
+    //pages already saved in the journal
+    std::unordered_set<std::uint64_t> journaled;
+    //cache slots
+    std::vector<Frame> frames;
+    //bytes of the cached pages, one page per frame
+    std::vector<char> frameBytes;
+    //frame holding each cached page
+    std::unordered_map<std::uint64_t,std::size_t> frameOf;
+    //position of the clock hand
+    std::size_t clockHand;
+    //counters reported by stats()
+    PageStats pageStats;
+    //to compare data based on specified comparator
+    CMP isless;
+};
+
+
+/**@class PagedSearchTree::iterator
+	@brief Bidirectional iterator over the values of a PagedSearchTree in order, walking the leaf chain. Values are read out of the page cache, so
+ dereferencing returns a copy.
+ */
+template <typename T,typename CMP>
+class PagedSearchTree<T,CMP>::iterator
+{
+public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef T reference;
+
+    //constructor for an iterator that points nowhere
+    iterator();
+    //copy of the value the iterator points at
+    T operator*() const;
+    //move to the next value, or end()
+    iterator& operator++();
+    iterator operator++(int);
+    //move to the previous value, end() moves to the largest
+    iterator& operator--();
+    iterator operator--(int);
+    //two iterators are equal if they point at the same position
+    bool operator==(const iterator& other) const;
+    bool operator!=(const iterator& other) const;
+
+private:
+    //tree iterated over
+    PagedSearchTree* tree;
+    //leaf page, 0 for end()
+    std::uint64_t leaf;
+    //position in the leaf
+    std::size_t index;
+    friend class PagedSearchTree;
+};
+
+
+/** Definition of the constructor. An existing file is checked against T, after rolling back any flush that did not finish. A new or empty file
+ gets a header and an empty root leaf, which are flushed right away.
+
+ @param path is the file holding the tree
+ @param cache_bytes is the memory the page cache may use, at least 16 pages are always cached
+ @throws std::system_error if the file can't be opened, read or written
+ @throws std::runtime_error if the file is not a PagedSearchTree of the same value size
+ */
+template <typename T,typename CMP>
+PagedSearchTree<T,CMP>::PagedSearchTree(const std::string& path, std::size_t cache_bytes) : filePath(path)
+{
+    journalFd = -1;
+    journalUnsynced = false;
+    metaDirty = false;
+    clockHand = 0;
+    pageStats = PageStats();
+    std::size_t frame_count = cache_bytes / page_size;
+    if (frame_count < 16) frame_count = 16;
+    frames.assign(frame_count, Frame{0, 0, false, false});
+    frameBytes.assign(frame_count * page_size, 0);
+
+    fd = ::open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "PagedSearchTree: open " + filePath);
+    try
+    {
+        recover();
+        struct stat info;
+        if (::fstat(fd, &info) != 0) throw std::system_error(errno, std::generic_category(), "PagedSearchTree: stat " + filePath);
+        if (info.st_size == 0)
+        {
+            //a new file, with the header in page 0 and an empty root leaf in page 1
+            meta = FileHeader();
+            meta.magic = 0x3130656572547342ULL;
+            meta.page_bytes = page_size;
+            meta.value_bytes = sizeof(T);
+            meta.page_count = 1;
+            flushedPages = 0;
+            std::uint64_t root;
+            std::size_t f = pin_new(root);
+            set_header(frame_data(f), PageHeader{1, 0, 0, 0});
+            unpin(f);
+            meta.root = meta.first_leaf = meta.last_leaf = root;
+            metaDirty = true;
+            flush();
+        }
+        else
+        {
+            char page[page_size];
+            read_raw(0, page);
+            std::memcpy(&meta, page, sizeof(meta));
+            if (meta.magic != 0x3130656572547342ULL || meta.page_bytes != page_size || meta.value_bytes != sizeof(T))
+                throw std::runtime_error("PagedSearchTree: " + filePath + " does not hold a tree of this value type");
+            flushedPages = meta.page_count;
+            //pages written after the last flush by a process that died are not part of the tree
+            if (::ftruncate(fd, static_cast<off_t>(flushedPages * page_size)) != 0)
+                throw std::system_error(errno, std::generic_category(), "PagedSearchTree: truncate " + filePath);
+        }
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+}
+
+
+/** Definition of the destructor. A destructor must not throw, so errors from the last flush are lost; call flush() first to see them.
+ */
+template <typename T,typename CMP>
+PagedSearchTree<T,CMP>::~PagedSearchTree()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+    }
+    if (journalFd >= 0)
+        ::close(journalFd);
+    ::close(fd);
+}
+
+
+/** Definition of the insert function. The value goes into the leaf it belongs in. A full leaf is split in half, the first key of the new right
+ half goes up into the parent as its separator, and a full parent is split the same way, up to the root.
+
+ @param value you want to insert
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::insert(const T& data)
+{
+    std::vector<std::pair<std::uint64_t,std::size_t>> path;
+    std::uint64_t leaf = descend(data, &path);
+    std::size_t f = pin(leaf);
+    char* page = frame_data(f);
+    PageHeader header = header_of(page);
+    std::size_t pos = key_lower_bound(page, header.count, data);
+    //if the value is already in the tree there is nothing to do
+    if (pos < header.count && !isless(data, key_at(page, pos)))
+    {
+        unpin(f);
+        return;
+    }
+    ++meta.size;
+    metaDirty = true;
+    mark_dirty(f);
+
+    if (header.count < leaf_capacity)
+    {
+        std::memmove(page + sizeof(PageHeader) + (pos + 1) * sizeof(T), page + sizeof(PageHeader) + pos * sizeof(T), (header.count - pos) * sizeof(T));
+        set_key(page, pos, data);
+        ++header.count;
+        set_header(page, header);
+        unpin(f);
+        return;
+    }
+
+    //split the full leaf, the left half stays in this page
+    std::vector<T> keys;
+    keys.reserve(header.count + 1);
+    for (std::size_t i = 0; i < header.count; ++i)
+        keys.push_back(key_at(page, i));
+    keys.insert(keys.begin() + pos, data);
+    std::size_t left_count = keys.size() / 2;
+
+    std::uint64_t right;
+    std::size_t rf = pin_new(right);
+    char* right_page = frame_data(rf);
+    for (std::size_t i = left_count; i < keys.size(); ++i)
+        set_key(right_page, i - left_count, keys[i]);
+    set_header(right_page, PageHeader{1, static_cast<std::uint32_t>(keys.size() - left_count), leaf, header.next});
+    //the new leaf goes between this leaf and the one after it
+    if (header.next != 0)
+    {
+        std::size_t nf = pin(header.next);
+        PageHeader next_header = header_of(frame_data(nf));
+        next_header.prev = right;
+        set_header(frame_data(nf), next_header);
+        mark_dirty(nf);
+        unpin(nf);
+    }
+    else
+        meta.last_leaf = right;
+    for (std::size_t i = 0; i < left_count; ++i)
+        set_key(page, i, keys[i]);
+    header.count = static_cast<std::uint32_t>(left_count);
+    header.next = right;
+    set_header(page, header);
+    unpin(rf);
+    unpin(f);
+    insert_separator(path, keys[left_count], right);
+}
+
+
+/** Definition of the insert_separator function. The separator goes right after the key that led down to the split page, and the new page right
+ after the split one. A full internal page is split around its middle key, which moves up instead of staying in either half. If the root is
+ split, a new root is made above it.
+
+ @param path holds the internal pages walked through and the child taken in each
+ @param key is the smallest key of the right page
+ @param right is the page that was split off
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::insert_separator(std::vector<std::pair<std::uint64_t,std::size_t>>& path, T key, std::uint64_t right)
+{
+    while (!path.empty())
+    {
+        std::uint64_t parent = path.back().first;
+        std::size_t idx = path.back().second;
+        path.pop_back();
+        std::size_t f = pin(parent);
+        char* page = frame_data(f);
+        PageHeader header = header_of(page);
+        mark_dirty(f);
+        if (header.count < internal_capacity)
+        {
+            char* keys = page + sizeof(PageHeader);
+            char* children = keys + internal_capacity * sizeof(T);
+            std::memmove(keys + (idx + 1) * sizeof(T), keys + idx * sizeof(T), (header.count - idx) * sizeof(T));
+            std::memmove(children + (idx + 2) * 8, children + (idx + 1) * 8, (header.count - idx) * 8);
+            set_key(page, idx, key);
+            set_child(page, idx + 1, right);
+            ++header.count;
+            set_header(page, header);
+            unpin(f);
+            return;
+        }
+
+        std::vector<T> keys;
+        std::vector<std::uint64_t> children;
+        for (std::size_t i = 0; i < header.count; ++i)
+            keys.push_back(key_at(page, i));
+        for (std::size_t i = 0; i <= header.count; ++i)
+            children.push_back(child_at(page, i));
+        keys.insert(keys.begin() + idx, key);
+        children.insert(children.begin() + idx + 1, right);
+        //the middle key moves up, the keys and children either side of it stay below
+        std::size_t mid = keys.size() / 2;
+
+        std::uint64_t new_page;
+        std::size_t rf = pin_new(new_page);
+        char* right_page = frame_data(rf);
+        for (std::size_t i = mid + 1; i < keys.size(); ++i)
+            set_key(right_page, i - mid - 1, keys[i]);
+        for (std::size_t i = mid + 1; i < children.size(); ++i)
+            set_child(right_page, i - mid - 1, children[i]);
+        set_header(right_page, PageHeader{0, static_cast<std::uint32_t>(keys.size() - mid - 1), 0, 0});
+        for (std::size_t i = 0; i < mid; ++i)
+            set_key(page, i, keys[i]);
+        for (std::size_t i = 0; i <= mid; ++i)
+            set_child(page, i, children[i]);
+        header.count = static_cast<std::uint32_t>(mid);
+        set_header(page, header);
+        unpin(rf);
+        unpin(f);
+        key = keys[mid];
+        right = new_page;
+    }
+
+    //the root was split, so the tree grows a level
+    std::uint64_t new_root;
+    std::size_t f = pin_new(new_root);
+    char* page = frame_data(f);
+    set_header(page, PageHeader{0, 1, 0, 0});
+    set_key(page, 0, key);
+    set_child(page, 0, meta.root);
+    set_child(page, 1, right);
+    unpin(f);
+    meta.root = new_root;
+}
+
+
+/** Definition of the erase function. The value is taken out of its leaf. A leaf that empties is unlinked from the leaf chain and its parent
+ and freed, and a root left with a single child is replaced by that child.
+
+ @param value you want to remove
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::erase(const T& data)
+{
+    std::vector<std::pair<std::uint64_t,std::size_t>> path;
+    std::uint64_t leaf = descend(data, &path);
+    std::size_t f = pin(leaf);
+    char* page = frame_data(f);
+    PageHeader header = header_of(page);
+    std::size_t pos = key_lower_bound(page, header.count, data);
+    //if we could not find the value, exit the function
+    if (pos == header.count || isless(data, key_at(page, pos)))
+    {
+        unpin(f);
+        return;
+    }
+    --meta.size;
+    metaDirty = true;
+    std::memmove(page + sizeof(PageHeader) + pos * sizeof(T), page + sizeof(PageHeader) + (pos + 1) * sizeof(T), (header.count - pos - 1) * sizeof(T));
+    --header.count;
+    set_header(page, header);
+    mark_dirty(f);
+    unpin(f);
+    //the root leaf stays even when it is empty
+    if (header.count > 0 || path.empty()) return;
+
+    //take the empty leaf out of the chain
+    if (header.prev != 0)
+    {
+        std::size_t pf = pin(header.prev);
+        PageHeader prev_header = header_of(frame_data(pf));
+        prev_header.next = header.next;
+        set_header(frame_data(pf), prev_header);
+        mark_dirty(pf);
+        unpin(pf);
+    }
+    else
+        meta.first_leaf = header.next;
+    if (header.next != 0)
+    {
+        std::size_t nf = pin(header.next);
+        PageHeader next_header = header_of(frame_data(nf));
+        next_header.prev = header.prev;
+        set_header(frame_data(nf), next_header);
+        mark_dirty(nf);
+        unpin(nf);
+    }
+    else
+        meta.last_leaf = header.prev;
+    free_page(leaf);
+    remove_child(path);
+
+    //a root with one child and no keys is not needed
+    for (;;)
+    {
+        std::size_t rf = pin(meta.root);
+        PageHeader root_header = header_of(frame_data(rf));
+        std::uint64_t only_child = child_at(frame_data(rf), 0);
+        unpin(rf);
+        if (root_header.leaf || root_header.count > 0) break;
+        free_page(meta.root);
+        meta.root = only_child;
+    }
+}
+
+
+/** Definition of the remove_child function. The child is taken out with the key before it, or the key after it if it is the first child. A
+ parent whose only child went is freed and taken out of its own parent in turn.
+
+ @param path holds the internal pages walked through and the child taken in each
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::remove_child(std::vector<std::pair<std::uint64_t,std::size_t>>& path)
+{
+    while (!path.empty())
+    {
+        std::uint64_t parent = path.back().first;
+        std::size_t idx = path.back().second;
+        path.pop_back();
+        std::size_t f = pin(parent);
+        char* page = frame_data(f);
+        PageHeader header = header_of(page);
+        if (header.count == 0)
+        {
+            unpin(f);
+            free_page(parent);
+            continue;
+        }
+        std::size_t key_idx = idx > 0 ? idx - 1 : 0;
+        char* keys = page + sizeof(PageHeader);
+        char* children = keys + internal_capacity * sizeof(T);
+        std::memmove(keys + key_idx * sizeof(T), keys + (key_idx + 1) * sizeof(T), (header.count - key_idx - 1) * sizeof(T));
+        std::memmove(children + idx * 8, children + (idx + 1) * 8, (header.count - idx) * 8);
+        --header.count;
+        set_header(page, header);
+        mark_dirty(f);
+        unpin(f);
+        return;
+    }
+}
+
+
+/** Definition of the lower_bound function
+
+ @param value you want to look up
+ @return iterator to the first value not less than data, or end() if there is none
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::iterator PagedSearchTree<T,CMP>::lower_bound(const T& data)
+{
+    std::uint64_t leaf = descend(data, nullptr);
+    std::size_t f = pin(leaf);
+    std::size_t pos = key_lower_bound(frame_data(f), header_of(frame_data(f)).count, data);
+    unpin(f);
+    return iterator_at(leaf, pos);
+}
+
+
+/** Definition of the find function, that searches the tree for a value.
+
+ @param value you want to look up
+ @return iterator to the value, or end() if it is not in the tree
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::iterator PagedSearchTree<T,CMP>::find(const T& data)
+{
+    iterator it = lower_bound(data);
+    //lower_bound stops at the first value not less than data, which is data unless data is less than it
+    if (it == end() || isless(data, *it)) return end();
+    return it;
+}
+
+
+/** Definition of the contains function.
+
+ @param value you want to look up
+ @return true if the value is in the tree
+ */
+template <typename T,typename CMP>
+bool PagedSearchTree<T,CMP>::contains(const T& data)
+{
+    return find(data) != end();
+}
+
+
+/** Definition of the begin() function
+
+ @return iterator to the smallest value, or end() if the tree is empty
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::iterator PagedSearchTree<T,CMP>::begin()
+{
+    return iterator_at(meta.first_leaf, 0);
+}
+
+
+/** Definition of the end() function
+
+ @return iterator to one after the largest value
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::iterator PagedSearchTree<T,CMP>::end()
+{
+    iterator it;
+    it.tree = this;
+    return it;
+}
+
+
+/** Definition of the size function
+
+ @return the number of values in the tree
+ */
+template <typename T,typename CMP>
+std::size_t PagedSearchTree<T,CMP>::size() const
+{
+    return meta.size;
+}
+
+
+/** Definition of the stats function
+
+ @return counters about the page cache and the file
+ */
+template <typename T,typename CMP>
+const PageStats& PagedSearchTree<T,CMP>::stats() const
+{
+    return pageStats;
+}
+
+
+/** Definition of the flush function. The old contents of every page about to be overwritten are journaled first, with a single sync. Then the
+ dirty pages and the header are written and the file is synced, and deleting the journal commits the new state.
+
+ @throws std::system_error if the file or the journal can't be written
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::flush()
+{
+    if (!metaDirty && journalFd < 0)
+    {
+        bool dirty = false;
+        for (const Frame& frame : frames)
+            dirty = dirty || frame.dirty;
+        if (!dirty) return;
+    }
+    for (const Frame& frame : frames)
+    {
+        if (frame.page != 0 && frame.dirty && frame.page < flushedPages && journaled.count(frame.page) == 0)
+            journal_page(frame.page);
+    }
+    if (flushedPages > 0 && journaled.count(0) == 0)
+        journal_page(0);
+    sync_journal();
+
+    for (std::size_t f = 0; f < frames.size(); ++f)
+    {
+        if (frames[f].page != 0 && frames[f].dirty)
+            write_page(f);
+    }
+    char header_page[page_size];
+    std::memset(header_page, 0, page_size);
+    std::memcpy(header_page, &meta, sizeof(meta));
+    write_raw(0, header_page);
+    ++pageStats.page_writes;
+    if (::fsync(fd) != 0) throw std::system_error(errno, std::generic_category(), "PagedSearchTree: sync " + filePath);
+
+    //deleting the journal is what commits the flush
+    if (journalFd >= 0)
+    {
+        ::close(journalFd);
+        journalFd = -1;
+        if (::unlink((filePath + "-journal").c_str()) != 0)
+            throw std::system_error(errno, std::generic_category(), "PagedSearchTree: remove journal of " + filePath);
+        sync_directory();
+    }
+    journaled.clear();
+    flushedPages = meta.page_count;
+    metaDirty = false;
+    ++pageStats.flushes;
+}
+
+
+/** Definition of the header_of function
+
+ @param page is the bytes of a tree page
+ @return its header
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::PageHeader PagedSearchTree<T,CMP>::header_of(const char* page)
+{
+    PageHeader header;
+    std::memcpy(&header, page, sizeof(header));
+    return header;
+}
+
+
+/** Definition of the set_header function
+
+ @param page is the bytes of a tree page
+ @param header to store in it
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::set_header(char* page, const PageHeader& header)
+{
+    std::memcpy(page, &header, sizeof(header));
+}
+
+
+/** Definition of the key_at function. Keys are copied out with memcpy, since they are not aligned within the page.
+
+ @param page is the bytes of a tree page
+ @param i is the index of the key
+ @return a copy of the key
+ */
+template <typename T,typename CMP>
+T PagedSearchTree<T,CMP>::key_at(const char* page, std::size_t i)
+{
+    T key;
+    std::memcpy(static_cast<void*>(&key), page + sizeof(PageHeader) + i * sizeof(T), sizeof(T));
+    return key;
+}
+
+
+/** Definition of the set_key function
+
+ @param page is the bytes of a tree page
+ @param i is the index of the key
+ @param key to store
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::set_key(char* page, std::size_t i, const T& key)
+{
+    std::memcpy(page + sizeof(PageHeader) + i * sizeof(T), static_cast<const void*>(&key), sizeof(T));
+}
+
+
+/** Definition of the child_at function. The child page numbers of an internal page come after room for internal_capacity keys.
+
+ @param page is the bytes of an internal page
+ @param i is the index of the child
+ @return the page number of the child
+ */
+template <typename T,typename CMP>
+std::uint64_t PagedSearchTree<T,CMP>::child_at(const char* page, std::size_t i)
+{
+    std::uint64_t child;
+    std::memcpy(&child, page + sizeof(PageHeader) + internal_capacity * sizeof(T) + i * 8, 8);
+    return child;
+}
+
+
+/** Definition of the set_child function
+
+ @param page is the bytes of an internal page
+ @param i is the index of the child
+ @param child is the page number of the child
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::set_child(char* page, std::size_t i, std::uint64_t child)
+{
+    std::memcpy(page + sizeof(PageHeader) + internal_capacity * sizeof(T) + i * 8, &child, 8);
+}
+
+
+/** Definition of the key_lower_bound function, a binary search over the keys of a page.
+
+ @param page is the bytes of a tree page
+ @param count is the number of keys in it
+ @param data is the value looked for
+ @return index of the first key not less than data, or count if there is none
+ */
+template <typename T,typename CMP>
+std::size_t PagedSearchTree<T,CMP>::key_lower_bound(const char* page, std::size_t count, const T& data) const
+{
+    std::size_t lo = 0;
+    std::size_t hi = count;
+    while (lo < hi)
+    {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (isless(key_at(page, mid), data))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+/** Definition of the descend function. In an internal page child i holds the values from key i-1 up to key i, so the search follows the child
+ after the last key that is not bigger than data.
+
+ @param data is the value looked for
+ @param path gets each internal page and the index of the child taken, if it is not nullptr
+ @return the leaf page data belongs in
+ */
+template <typename T,typename CMP>
+std::uint64_t PagedSearchTree<T,CMP>::descend(const T& data, std::vector<std::pair<std::uint64_t,std::size_t>>* path)
+{
+    std::uint64_t page = meta.root;
+    for (;;)
+    {
+        std::size_t f = pin(page);
+        const char* bytes = frame_data(f);
+        PageHeader header = header_of(bytes);
+        if (header.leaf)
+        {
+            unpin(f);
+            return page;
+        }
+        std::size_t lo = 0;
+        std::size_t hi = header.count;
+        while (lo < hi)
+        {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (isless(data, key_at(bytes, mid)))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        std::uint64_t child = child_at(bytes, lo);
+        unpin(f);
+        if (path != nullptr)
+            path->push_back(std::make_pair(page, lo));
+        page = child;
+    }
+}
+
+
+/** Definition of the iterator_at function
+
+ @param leaf is the leaf page
+ @param index is the position in it, which may be its count
+ @return iterator to that value, or to the first value of a later leaf, or end()
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::iterator PagedSearchTree<T,CMP>::iterator_at(std::uint64_t leaf, std::size_t index)
+{
+    iterator it;
+    it.tree = this;
+    while (leaf != 0)
+    {
+        std::size_t f = pin(leaf);
+        PageHeader header = header_of(frame_data(f));
+        unpin(f);
+        if (index < header.count)
+        {
+            it.leaf = leaf;
+            it.index = index;
+            return it;
+        }
+        leaf = header.next;
+        index = 0;
+    }
+    return it;
+}
+
+
+/** Definition of the pin function. A cached page only gets its referenced bit set, otherwise a frame is freed up and the page read into it.
+ A pinned frame is never evicted, so its bytes stay put until it is unpinned.
+
+ @param page is the page number
+ @return the frame holding the page
+ */
+template <typename T,typename CMP>
+std::size_t PagedSearchTree<T,CMP>::pin(std::uint64_t page)
+{
+    std::unordered_map<std::uint64_t,std::size_t>::iterator it = frameOf.find(page);
+    if (it != frameOf.end())
+    {
+        ++pageStats.cache_hits;
+        Frame& frame = frames[it->second];
+        ++frame.pins;
+        frame.referenced = true;
+        return it->second;
+    }
+    ++pageStats.cache_misses;
+    std::size_t f = free_frame();
+    read_raw(page, frame_data(f));
+    frames[f] = Frame{page, 1, false, true};
+    frameOf[page] = f;
+    return f;
+}
+
+
+/** Definition of the pin_new function. A page from the free list is reused first, otherwise the file grows by a page. The page does not have to
+ be read, it starts out zeroed and dirty.
+
+ @param page gets the new page number
+ @return the frame holding the page
+ */
+template <typename T,typename CMP>
+std::size_t PagedSearchTree<T,CMP>::pin_new(std::uint64_t& page)
+{
+    std::size_t f;
+    if (meta.free_list != 0)
+    {
+        //a free page holds the number of the next free page
+        page = meta.free_list;
+        f = pin(page);
+        std::memcpy(&meta.free_list, frame_data(f), 8);
+    }
+    else
+    {
+        page = meta.page_count++;
+        f = free_frame();
+        frames[f] = Frame{page, 1, false, true};
+        frameOf[page] = f;
+    }
+    metaDirty = true;
+    std::memset(frame_data(f), 0, page_size);
+    mark_dirty(f);
+    return f;
+}
+
+
+/** Definition of the unpin function
+
+ @param frame is a frame returned by pin or pin_new
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::unpin(std::size_t frame)
+{
+    --frames[frame].pins;
+}
+
+
+/** Definition of the frame_data function
+
+ @param frame is a cache slot
+ @return the bytes of the page it holds
+ */
+template <typename T,typename CMP>
+char* PagedSearchTree<T,CMP>::frame_data(std::size_t frame)
+{
+    return frameBytes.data() + frame * page_size;
+}
+
+
+/** Definition of the mark_dirty function
+
+ @param frame is a pinned frame that was changed
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::mark_dirty(std::size_t frame)
+{
+    frames[frame].dirty = true;
+}
+
+
+/** Definition of the free_page function, that pushes a page onto the free list by storing the old head of the list in it.
+
+ @param page is a page no longer used by the tree
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::free_page(std::uint64_t page)
+{
+    std::size_t f = pin(page);
+    std::memset(frame_data(f), 0, page_size);
+    std::memcpy(frame_data(f), &meta.free_list, 8);
+    mark_dirty(f);
+    unpin(f);
+    meta.free_list = page;
+    metaDirty = true;
+}
+
+
+/** Definition of the free_frame function, the CLOCK algorithm. The hand passes over pinned frames and clears the referenced bit of the others,
+ so a frame is only evicted if it was not used since the hand last came by. A dirty frame is written back before it is reused.
+
+ @return an empty frame
+ @throws std::runtime_error if every frame is pinned
+ */
+template <typename T,typename CMP>
+std::size_t PagedSearchTree<T,CMP>::free_frame()
+{
+    //two full turns clear every referenced bit, so an unpinned frame is found by then
+    for (std::size_t step = 0; step <= 2 * frames.size(); ++step)
+    {
+        std::size_t f = clockHand;
+        clockHand = (clockHand + 1) % frames.size();
+        Frame& frame = frames[f];
+        if (frame.page == 0) return f;
+        if (frame.pins > 0) continue;
+        if (frame.referenced)
+        {
+            frame.referenced = false;
+            continue;
+        }
+        if (frame.dirty)
+            write_page(f);
+        frameOf.erase(frame.page);
+        frame.page = 0;
+        ++pageStats.evictions;
+        return f;
+    }
+    throw std::runtime_error("PagedSearchTree: every cached page is pinned");
+}
+
+
+/** Definition of the write_page function. A page of the last flushed state is journaled, and the journal synced, before it is overwritten for
+ the first time since that flush.
+
+ @param frame is a dirty frame
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::write_page(std::size_t frame)
+{
+    std::uint64_t page = frames[frame].page;
+    if (page < flushedPages && journaled.count(page) == 0)
+    {
+        journal_page(page);
+        sync_journal();
+    }
+    write_raw(page, frame_data(frame));
+    ++pageStats.page_writes;
+    frames[frame].dirty = false;
+}
+
+
+/** Definition of the journal_page function. The journal starts with its magic number and the number of pages of the last flushed state, and
+ each record holds a page number, a checksum and the old page. The first record creates the journal and syncs its directory entry.
+
+ @param page is a page of the last flushed state
+ @throws std::system_error if the journal can't be written
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::journal_page(std::uint64_t page)
+{
+    if (journalFd < 0)
+    {
+        journalFd = ::open((filePath + "-journal").c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (journalFd < 0) throw std::system_error(errno, std::generic_category(), "PagedSearchTree: create journal of " + filePath);
+        std::uint64_t start[2] = {0x6C6E72756F4A7342ULL, flushedPages};
+        if (::pwrite(journalFd, start, sizeof(start), 0) != static_cast<ssize_t>(sizeof(start)))
+            throw std::system_error(errno, std::generic_category(), "PagedSearchTree: write journal of " + filePath);
+        if (::fsync(journalFd) != 0) throw std::system_error(errno, std::generic_category(), "PagedSearchTree: sync journal of " + filePath);
+        sync_directory();
+    }
+    char record[16 + page_size];
+    read_raw(page, record + 16);
+    std::uint64_t sum = checksum(page, record + 16);
+    std::memcpy(record, &page, 8);
+    std::memcpy(record + 8, &sum, 8);
+    off_t offset = static_cast<off_t>(16 + journaled.size() * sizeof(record));
+    if (::pwrite(journalFd, record, sizeof(record), offset) != static_cast<ssize_t>(sizeof(record)))
+        throw std::system_error(errno, std::generic_category(), "PagedSearchTree: write journal of " + filePath);
+    journaled.insert(page);
+    journalUnsynced = true;
+    ++pageStats.journal_writes;
+}
+
+
+/** Definition of the sync_journal function
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::sync_journal()
+{
+    if (!journalUnsynced) return;
+    if (::fsync(journalFd) != 0) throw std::system_error(errno, std::generic_category(), "PagedSearchTree: sync journal of " + filePath);
+    journalUnsynced = false;
+}
+
+
+/** Definition of the recover function. Every record up to the first torn one is copied back, which is safe since a page was only overwritten
+ after its record was synced. The file is then cut back to the pages of the last flushed state and synced before the journal is deleted.
+ A journal without a complete start was never synced, so the file was not touched and the journal is just deleted.
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::recover()
+{
+    std::string journal_path = filePath + "-journal";
+    int journal = ::open(journal_path.c_str(), O_RDONLY);
+    if (journal < 0)
+    {
+        if (errno == ENOENT) return;
+        throw std::system_error(errno, std::generic_category(), "PagedSearchTree: open journal of " + filePath);
+    }
+    std::uint64_t start[2];
+    if (::pread(journal, start, sizeof(start), 0) == static_cast<ssize_t>(sizeof(start)) && start[0] == 0x6C6E72756F4A7342ULL)
+    {
+        char record[16 + page_size];
+        for (off_t offset = sizeof(start); ::pread(journal, record, sizeof(record), offset) == static_cast<ssize_t>(sizeof(record)); offset += sizeof(record))
+        {
+            std::uint64_t page;
+            std::uint64_t sum;
+            std::memcpy(&page, record, 8);
+            std::memcpy(&sum, record + 8, 8);
+            if (sum != checksum(page, record + 16)) break;
+            write_raw(page, record + 16);
+        }
+        if (::ftruncate(fd, static_cast<off_t>(start[1] * page_size)) != 0 || ::fsync(fd) != 0)
+        {
+            int error = errno;
+            ::close(journal);
+            throw std::system_error(error, std::generic_category(), "PagedSearchTree: roll back " + filePath);
+        }
+    }
+    ::close(journal);
+    if (::unlink(journal_path.c_str()) != 0) throw std::system_error(errno, std::generic_category(), "PagedSearchTree: remove journal of " + filePath);
+    sync_directory();
+}
+
+
+/** Definition of the read_raw function. pread may return less than asked or be interrupted, so it is repeated until the page is read.
+
+ @param page is the page number
+ @param out gets the page_size bytes of the page
+ @throws std::system_error if reading fails, std::runtime_error if the file ends early
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::read_raw(std::uint64_t page, char* out)
+{
+    std::size_t done = 0;
+    while (done < page_size)
+    {
+        ssize_t got = ::pread(fd, out + done, page_size - done, static_cast<off_t>(page * page_size + done));
+        if (got < 0)
+        {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "PagedSearchTree: read " + filePath);
+        }
+        if (got == 0) throw std::runtime_error("PagedSearchTree: " + filePath + " ends in the middle of the tree");
+        done += static_cast<std::size_t>(got);
+    }
+    ++pageStats.page_reads;
+}
+
+
+/** Definition of the write_raw function. pwrite may write less than asked or be interrupted, so it is repeated until the page is written.
+
+ @param page is the page number
+ @param data is the page_size bytes of the page
+ @throws std::system_error if writing fails
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::write_raw(std::uint64_t page, const char* data)
+{
+    std::size_t done = 0;
+    while (done < page_size)
+    {
+        ssize_t written = ::pwrite(fd, data + done, page_size - done, static_cast<off_t>(page * page_size + done));
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "PagedSearchTree: write " + filePath);
+        }
+        done += static_cast<std::size_t>(written);
+    }
+}
+
+
+/** Definition of the sync_directory function
+ */
+template <typename T,typename CMP>
+void PagedSearchTree<T,CMP>::sync_directory()
+{
+    std::string::size_type slash = filePath.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : filePath.substr(0, slash));
+    int dir_fd = ::open(dir.c_str(), O_RDONLY);
+    if (dir_fd < 0) throw std::system_error(errno, std::generic_category(), "PagedSearchTree: open " + dir);
+    int result = ::fsync(dir_fd);
+    int error = errno;
+    ::close(dir_fd);
+    if (result != 0) throw std::system_error(error, std::generic_category(), "PagedSearchTree: sync " + dir);
+}
+
+
+/** Definition of the checksum function, FNV-1a over the page number and the page, so a torn journal record is not copied back.
+
+ @param page is the page number
+ @param data is the page_size bytes of the page
+ @return the checksum
+ */
+template <typename T,typename CMP>
+std::uint64_t PagedSearchTree<T,CMP>::checksum(std::uint64_t page, const char* data)
+{
+    std::uint64_t hash = 14695981039346656037ULL ^ page;
+    for (std::size_t i = 0; i < page_size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+/** Definition of the iterator constructor
+ */
+template <typename T,typename CMP>
+PagedSearchTree<T,CMP>::iterator::iterator()
+{
+    tree = nullptr;
+    leaf = 0;
+    index = 0;
+}
+
+
+/** Definition of the dereference operator
+
+ @return a copy of the value the iterator points at
+ */
+template <typename T,typename CMP>
+T PagedSearchTree<T,CMP>::iterator::operator*() const
+{
+    std::size_t f = tree->pin(leaf);
+    T value = key_at(tree->frame_data(f), index);
+    tree->unpin(f);
+    return value;
+}
+
+
+/** Definition of the pre-increment operator, that moves along the leaf chain at the end of a leaf.
+
+ @return the iterator at the next value, or end()
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::iterator& PagedSearchTree<T,CMP>::iterator::operator++()
+{
+    *this = tree->iterator_at(leaf, index + 1);
+    return *this;
+}
+
+
+/** Definition of the post-increment operator
+
+ @return the iterator before it moved
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::iterator PagedSearchTree<T,CMP>::iterator::operator++(int)
+{
+    iterator old = *this;
+    ++*this;
+    return old;
+}
+
+
+/** Definition of the pre-decrement operator, that moves back along the leaf chain at the start of a leaf. end() moves to the largest value.
+
+ @return the iterator at the previous value
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::iterator& PagedSearchTree<T,CMP>::iterator::operator--()
+{
+    std::uint64_t page = leaf;
+    std::size_t pos = index;
+    if (page == 0)
+    {
+        page = tree->meta.last_leaf;
+        std::size_t f = tree->pin(page);
+        pos = header_of(tree->frame_data(f)).count;
+        tree->unpin(f);
+    }
+    while (pos == 0)
+    {
+        std::size_t f = tree->pin(page);
+        page = header_of(tree->frame_data(f)).prev;
+        tree->unpin(f);
+        f = tree->pin(page);
+        pos = header_of(tree->frame_data(f)).count;
+        tree->unpin(f);
+    }
+    leaf = page;
+    index = pos - 1;
+    return *this;
+}
+
+
+/** Definition of the post-decrement operator
+
+ @return the iterator before it moved
+ */
+template <typename T,typename CMP>
+typename PagedSearchTree<T,CMP>::iterator PagedSearchTree<T,CMP>::iterator::operator--(int)
+{
+    iterator old = *this;
+    --*this;
+    return old;
+}
+
+
+/** Definition of the == operator
+
+ @return true if both iterators point at the same position
+ */
+template <typename T,typename CMP>
+bool PagedSearchTree<T,CMP>::iterator::operator==(const iterator& other) const
+{
+    return leaf == other.leaf && index == other.index;
+}
+
+
+/** Definition of the != operator
+
+ @return true if the iterators point at different positions
+ */
+template <typename T,typename CMP>
+bool PagedSearchTree<T,CMP>::iterator::operator!=(const iterator& other) const
+{
+    return !(*this == other);
+}
+
+
+#endif /* PagedSearchTree_h */
@@ -14,6 +14,8 @@
 
 #include <stdio.h>
 #include <iostream>
+#include <algorithm>
+#include <limits>
 
 class Point2D
 {
@@ -22,8 +24,8 @@ public:
     Point2D(){};
     Point2D(int x, int y):x(x), y(y){};
     //getters
-    int getx();
-    int gety();
+    int getx() const;
+    int gety() const;
     
 private:
     //x position
@@ -55,7 +57,7 @@ std::ostream& operator<<(std::ostream&os, Point2D x)
  @return value of the Point2D's x position
  
  */
-int Point2D::getx()
+int Point2D::getx() const
 {
     return x;
 }
@@ -64,10 +66,66 @@ int Point2D::getx()
  @return value of the Point2D's y position
  
  */
-int Point2D::gety()
+int Point2D::gety() const
 {
     return y;
 }
 
 
+/**@struct BoundingBox
+	@brief Smallest axis aligned box holding a set of points, empty when min_x > max_x
+ */
+struct BoundingBox
+{
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+};
+
+
+/**@struct BoundingBoxSummary
+	@brief Summary policy (see TreeSummary.h) keeping the bounding box of the points in a subtree, so that for example a tree ordered by
+ PointOrderx answers "the bounding box of every point with x in [a, b)" with aggregate(a, b)
+ */
+struct BoundingBoxSummary
+{
+    typedef BoundingBox summary_type;
+    static summary_type identity();
+    static summary_type from_value(const Point2D& p);
+    static summary_type combine(const summary_type& a, const summary_type& b);
+};
+
+/** the empty box, which combine leaves unchanged
+ 
+ @return a box with min above max
+ */
+inline BoundingBox BoundingBoxSummary::identity()
+{
+    return BoundingBox{std::numeric_limits<int>::max(), std::numeric_limits<int>::max(),
+                       std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
+}
+
+/** the box of a single point
+ 
+ @param p is the point
+ @return a box holding only p
+ */
+inline BoundingBox BoundingBoxSummary::from_value(const Point2D& p)
+{
+    return BoundingBox{p.getx(), p.gety(), p.getx(), p.gety()};
+}
+
+/** the smallest box holding two boxes
+ 
+ @param a is the first box
+ @param b is the second box
+ @return the box around both
+ */
+inline BoundingBox BoundingBoxSummary::combine(const BoundingBox& a, const BoundingBox& b)
+{
+    return BoundingBox{std::min(a.min_x, b.min_x), std::min(a.min_y, b.min_y), std::max(a.max_x, b.max_x), std::max(a.max_y, b.max_y)};
+}
+
+
 #endif /* Point2D_h */
@@ -0,0 +1,1028 @@
+/** @file RadixTree.h
+ @brief Contains the class declarations and definitions for a RadixTree templated class, an adaptive radix tree for std::string keys.
+
+ The RadixTree is an index for string keys with long shared prefixes (URLs, paths). Instead of comparing whole strings at every node, it walks
+ the key one byte at a time, and each node stores the bytes its keys share (the compressed prefix) only once. Nodes come in four sizes, like the
+ adaptive radix tree: up to 4, 16 or 48 children kept in small arrays, or 256 children indexed directly by the next byte. A node grows or shrinks
+ to the next size as children are added or removed, and a leaf is just a header and its remaining bytes. The prefix bytes live in the same
+ allocation as the node header.
+
+ It offers the same insert, find, erase and ordered iteration interface as BinarySearchTree<std::string,CMP>. Bytes are compared as unsigned
+ char, which is the order std::less<std::string> uses, so iteration gives the same order as the tree, and the reverse order for
+ std::greater<std::string>. Iterators only go forward.
+ */
+
+#ifndef RadixTree_h
+#define RadixTree_h
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename CMP=std::less<std::string>>
+class RadixTree
+{
+public:
+    class iterator;
+    //constructor
+    RadixTree();
+    //deep copy constructor
+    RadixTree(const RadixTree& copy);
+    //move constructor
+    RadixTree(RadixTree&& copy);
+    //assignment operator
+    RadixTree& operator=(RadixTree assign);
+    //destructor
+    ~RadixTree();
+    //insert key, returns false if it was already there
+    bool insert(const std::string& key);
+    //remove key, returns false if it was not there
+    bool erase(const std::string& key);
+    //find key, returns end() if it is not in the tree
+    iterator find(const std::string& key) const;
+    //check whether key is in the tree
+    bool contains(const std::string& key) const;
+    //access iterator to the first key and one after the last key
+    iterator begin() const;
+    iterator end() const;
+    //number of keys in the tree
+    std::size_t size() const;
+    //bytes allocated for nodes and their prefixes
+    std::size_t memory_usage() const;
+    //exchange contents with another tree
+    void swap(RadixTree& other);
+
+private:
+    //the four node sizes, and leaves that have no children
+    enum NodeType { LEAF, NODE4, NODE16, NODE48, NODE256 };
+
+    //header shared by every node, followed in memory by the node's children and then its prefix bytes
+    struct Node
+    {
+        //which NodeType this is
+        unsigned char type;
+        //true if a key ends at this node
+        unsigned char terminal;
+        //number of children
+        unsigned short count;
+        //number of prefix bytes
+        unsigned int prefixLength;
+    };
+    //up to 4 or 16 children, with their bytes kept sorted
+    struct Node4 : Node { unsigned char keys[4]; Node* children[4]; };
+    struct Node16 : Node { unsigned char keys[16]; Node* children[16]; };
+    //up to 48 children, index holds the slot of each byte plus one (0 means no child)
+    struct Node48 : Node { unsigned char index[256]; Node* children[48]; };
+    //one child pointer per byte
+    struct Node256 : Node { Node* children[256]; };
+
+    //false for std::less, true for std::greater
+    static const bool reversed = std::is_same<CMP, std::greater<std::string>>::value;
+    static_assert(std::is_same<CMP, std::less<std::string>>::value || reversed,
+                  "RadixTree orders keys by std::less<std::string> or std::greater<std::string>");
+
+    //size of the fixed part of a node of the given type
+    static std::size_t header_size(unsigned char type);
+    //the prefix bytes stored after a node's header
+    static unsigned char* prefix(Node* N);
+    //most children a node of the given type can hold
+    static unsigned capacity(unsigned char type);
+    //smallest node type that holds count children
+    static unsigned char type_for(unsigned count);
+    //the slot holding the child for byte c, or nullptr if there is none
+    static Node** find_child(Node* N, unsigned char c);
+    //the child after (or before, going in reverse) byte after, setting byte to its byte
+    static Node* next_child(Node* N, int after, bool reverse, unsigned char& byte);
+    //call f(byte, child) for each child in byte order
+    template <typename F>
+    static void for_each_child(Node* N, F f);
+    //add a child to a node that has room for it
+    static void add_child_raw(Node* N, unsigned char c, Node* child);
+
+    //allocate an empty node with the given prefix
+    Node* make_node(unsigned char type, const unsigned char* bytes, std::size_t length);
+    //make a copy of N with a new type and prefix, keeping its children and terminal flag, and free N
+    Node* remake(Node* N, unsigned char type, const unsigned char* bytes, std::size_t length);
+    //free one node
+    void free_node(Node* N);
+    //add a child to the node in slot ref, growing it if it is full
+    void add_child(Node** ref, unsigned char c, Node* child);
+    //remove the child for byte c from the node in slot ref, shrinking it if it got small
+    void remove_child(Node** ref, unsigned char c);
+    //remove the rest of key from the subtree in slot ref
+    bool erase_from(Node** ref, const unsigned char* key, std::size_t length, std::size_t depth);
+    //deep copy a subtree
+    Node* copy_helper(Node* N);
+    //free a subtree
+    void destroy(Node* N);
+
+    //the root node, nullptr if the tree is empty
+    Node* root;
+    //number of keys
+    std::size_t keyCount;
+    //bytes allocated for nodes
+    std::size_t memoryBytes;
+};
+
+
+/**@class RadixTree::iterator
+	@brief Forward iterator over the keys of a RadixTree in order. It keeps the path from the root to the current node, and builds the current
+ key as it walks, so dereferencing it gives a reference to a string it owns.
+ */
+template <typename CMP>
+class RadixTree<CMP>::iterator
+{
+public:
+    //prefix next key operator
+    iterator& operator++();
+    //postfix next key operator
+    iterator operator++(int);
+    //access the current key
+    const std::string& operator*() const;
+    const std::string* operator->() const;
+    //comparison operators
+    bool operator==(const iterator& other) const;
+    bool operator!=(const iterator& other) const;
+
+private:
+    //one node on the path from the root
+    struct Frame
+    {
+        //the node
+        Node* node;
+        //length of the key before this node's prefix
+        std::size_t base;
+        //byte of the last child visited
+        int last;
+        //true once the node's prefix has been added to the key
+        bool started;
+        //true once the node's own key was visited (only used in reverse order)
+        bool terminalDone;
+    };
+    //move to the next key, or to the end if there is none
+    void advance();
+    //start a frame for a node whose key starts after base bytes
+    void push(Node* N, std::size_t base);
+    //path from the root to the current node, empty at the end
+    std::vector<Frame> path;
+    //the current key
+    std::string key;
+    //declare friend class
+    friend class RadixTree<CMP>;
+};
+
+
+/** Definition of standard constructor, that makes an empty tree
+ */
+template <typename CMP>
+RadixTree<CMP>::RadixTree()
+{
+    root = nullptr;
+    keyCount = 0;
+    memoryBytes = 0;
+}
+
+
+/** Definition of deep copy constructor, which copies every node of the tree.
+
+ @param tree that you want to make a copy of
+ */
+template <typename CMP>
+RadixTree<CMP>::RadixTree(const RadixTree& copy) : RadixTree()
+{
+    root = copy_helper(copy.root);
+    keyCount = copy.keyCount;
+}
+
+
+/** Definition of move constructor, which steals the nodes of its parameter.
+
+ @param tree that you want to move from
+ */
+template <typename CMP>
+RadixTree<CMP>::RadixTree(RadixTree&& copy) : RadixTree()
+{
+    swap(copy);
+}
+
+
+/** Overloading the assignment operator using the copy swap idiom.
+
+ @param tree that you want to assign
+ @return reference to this tree
+ */
+template <typename CMP>
+RadixTree<CMP>& RadixTree<CMP>::operator=(RadixTree assign)
+{
+    swap(assign);
+    return *this;
+}
+
+
+/** Definition of the destructor, which frees every node.
+ */
+template <typename CMP>
+RadixTree<CMP>::~RadixTree()
+{
+    destroy(root);
+}
+
+
+/** Definition of the swap function, that exchanges the nodes of two trees.
+
+ @param other is the tree to swap with
+ */
+template <typename CMP>
+void RadixTree<CMP>::swap(RadixTree& other)
+{
+    std::swap(root, other.root);
+    std::swap(keyCount, other.keyCount);
+    std::swap(memoryBytes, other.memoryBytes);
+}
+
+
+/** Definition of the insert function. It follows the key down the tree one prefix and one byte at a time. If the key leaves a node's prefix
+ part way, the node is split into a new node holding the shared part; if it runs out of tree, a leaf holding the rest of the key is added.
+
+ @param key you want to insert
+ @return true if the key was inserted, false if it was already in the tree
+ */
+template <typename CMP>
+bool RadixTree<CMP>::insert(const std::string& key)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.data());
+    std::size_t length = key.size();
+    std::size_t depth = 0;
+    Node** ref = &root;
+
+    while (true)
+    {
+        Node* N = *ref;
+        //ran out of tree, the rest of the key becomes a leaf
+        if (N == nullptr)
+        {
+            *ref = make_node(LEAF, bytes + depth, length - depth);
+            (*ref)->terminal = 1;
+            ++keyCount;
+            return true;
+        }
+
+        //count how much of the node's prefix the key shares
+        unsigned char* p = prefix(N);
+        std::size_t match = 0;
+        while (match < N->prefixLength && depth + match < length && p[match] == bytes[depth + match])
+            ++match;
+
+        //the key leaves the prefix part way, so split the node where they differ
+        if (match < N->prefixLength)
+        {
+            Node* split = make_node(NODE4, p, match);
+            unsigned char old_byte = p[match];
+            Node* rest = remake(N, N->type, p + match + 1, N->prefixLength - match - 1);
+            add_child_raw(split, old_byte, rest);
+            if (depth + match == length)
+                split->terminal = 1;
+            else
+            {
+                Node* leaf = make_node(LEAF, bytes + depth + match + 1, length - depth - match - 1);
+                leaf->terminal = 1;
+                add_child_raw(split, bytes[depth + match], leaf);
+            }
+            *ref = split;
+            ++keyCount;
+            return true;
+        }
+
+        depth += N->prefixLength;
+        //the key ends at this node
+        if (depth == length)
+        {
+            if (N->terminal) return false;
+            N->terminal = 1;
+            ++keyCount;
+            return true;
+        }
+
+        //follow the next byte, or hang a new leaf off this node
+        Node** child = find_child(N, bytes[depth]);
+        if (child == nullptr)
+        {
+            Node* leaf = make_node(LEAF, bytes + depth + 1, length - depth - 1);
+            leaf->terminal = 1;
+            add_child(ref, bytes[depth], leaf);
+            ++keyCount;
+            return true;
+        }
+        ref = child;
+        ++depth;
+    }
+}
+
+
+/** Definition of the erase function, that removes a key and cleans up the path behind it.
+
+ @param key you want to remove
+ @return true if the key was removed, false if it was not in the tree
+ */
+template <typename CMP>
+bool RadixTree<CMP>::erase(const std::string& key)
+{
+    if (!erase_from(&root, reinterpret_cast<const unsigned char*>(key.data()), key.size(), 0))
+        return false;
+    --keyCount;
+    return true;
+}
+
+
+/** Definition of the erase_from function. After removing the key below it, a node that no longer holds a key or any children is freed, and a
+ node left with no key and a single child is merged into that child, so prefixes stay compressed.
+
+ @param ref is the slot holding the subtree
+ @param key is the key being removed
+ @param length is the length of the key
+ @param depth is how many bytes of the key were matched above this subtree
+ @return true if the key was found and removed
+ */
+template <typename CMP>
+bool RadixTree<CMP>::erase_from(Node** ref, const unsigned char* key, std::size_t length, std::size_t depth)
+{
+    Node* N = *ref;
+    if (N == nullptr) return false;
+    if (length - depth < N->prefixLength || std::memcmp(prefix(N), key + depth, N->prefixLength) != 0)
+        return false;
+    depth += N->prefixLength;
+
+    if (depth == length)
+    {
+        if (!N->terminal) return false;
+        N->terminal = 0;
+    }
+    else
+    {
+        unsigned char c = key[depth];
+        Node** child = find_child(N, c);
+        if (child == nullptr || !erase_from(child, key, length, depth + 1))
+            return false;
+        //the child went away entirely
+        if (*child == nullptr)
+            remove_child(ref, c);
+        N = *ref;
+    }
+
+    //nothing left here
+    if (!N->terminal && N->count == 0)
+    {
+        free_node(N);
+        *ref = nullptr;
+    }
+    //one child and no key, so fold this node's prefix into the child
+    else if (!N->terminal && N->count == 1)
+    {
+        unsigned char c = 0;
+        Node* child = next_child(N, -1, false, c);
+        std::string joined(reinterpret_cast<char*>(prefix(N)), N->prefixLength);
+        joined.push_back(static_cast<char>(c));
+        joined.append(reinterpret_cast<char*>(prefix(child)), child->prefixLength);
+        *ref = remake(child, child->type, reinterpret_cast<const unsigned char*>(joined.data()), joined.size());
+        free_node(N);
+    }
+    return true;
+}
+
+
+/** Definition of the contains function, that follows the key down the tree.
+
+ @param key you want to look up
+ @return true if the key is in the tree
+ */
+template <typename CMP>
+bool RadixTree<CMP>::contains(const std::string& key) const
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.data());
+    std::size_t length = key.size();
+    std::size_t depth = 0;
+    Node* N = root;
+    while (N != nullptr)
+    {
+        if (length - depth < N->prefixLength || std::memcmp(prefix(N), bytes + depth, N->prefixLength) != 0)
+            return false;
+        depth += N->prefixLength;
+        if (depth == length)
+            return N->terminal != 0;
+        Node** child = find_child(N, bytes[depth]);
+        if (child == nullptr) return false;
+        N = *child;
+        ++depth;
+    }
+    return false;
+}
+
+
+/** Definition of the find function, that follows the key down the tree and builds an iterator positioned at it.
+
+ @param key you want to look up
+ @return iterator to the key, or end() if it is not in the tree
+ */
+template <typename CMP>
+typename RadixTree<CMP>::iterator RadixTree<CMP>::find(const std::string& key) const
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.data());
+    std::size_t length = key.size();
+    std::size_t depth = 0;
+    iterator it;
+    Node* N = root;
+    while (N != nullptr)
+    {
+        if (length - depth < N->prefixLength || std::memcmp(prefix(N), bytes + depth, N->prefixLength) != 0)
+            return end();
+        it.push(N, depth);
+        it.path.back().started = true;
+        depth += N->prefixLength;
+        if (depth == length)
+        {
+            if (!N->terminal) return end();
+            //in reverse order a node's key comes after its children, so those are done
+            if (reversed)
+            {
+                it.path.back().last = -1;
+                it.path.back().terminalDone = true;
+            }
+            it.key = key;
+            return it;
+        }
+        Node** child = find_child(N, bytes[depth]);
+        if (child == nullptr) return end();
+        //carry on after this child when the iterator moves on
+        it.path.back().last = bytes[depth];
+        N = *child;
+        ++depth;
+    }
+    return end();
+}
+
+
+/** Definition of the begin() function, returns an iterator to the first key in CMP order
+
+ @return iterator to the first key, or end() if the tree is empty
+ */
+template <typename CMP>
+typename RadixTree<CMP>::iterator RadixTree<CMP>::begin() const
+{
+    iterator it;
+    if (root != nullptr)
+    {
+        it.push(root, 0);
+        it.advance();
+    }
+    return it;
+}
+
+
+/** Definition of the end() function, returns an iterator to the position after the last key
+
+ @return iterator to one after the last key
+ */
+template <typename CMP>
+typename RadixTree<CMP>::iterator RadixTree<CMP>::end() const
+{
+    return iterator();
+}
+
+
+/** Definition of the size function
+
+ @return the number of keys in the tree
+ */
+template <typename CMP>
+std::size_t RadixTree<CMP>::size() const
+{
+    return keyCount;
+}
+
+
+/** Definition of the memory_usage function
+
+ @return the number of bytes allocated for nodes, including their prefix bytes
+ */
+template <typename CMP>
+std::size_t RadixTree<CMP>::memory_usage() const
+{
+    return memoryBytes;
+}
+
+
+/** Definition of the header_size function
+
+ @param type of node
+ @return number of bytes before the node's prefix
+ */
+template <typename CMP>
+std::size_t RadixTree<CMP>::header_size(unsigned char type)
+{
+    switch (type)
+    {
+        case NODE4: return sizeof(Node4);
+        case NODE16: return sizeof(Node16);
+        case NODE48: return sizeof(Node48);
+        case NODE256: return sizeof(Node256);
+        default: return sizeof(Node);
+    }
+}
+
+
+/** Definition of the prefix function
+
+ @param N is the node
+ @return pointer to the node's prefix bytes, which follow its header
+ */
+template <typename CMP>
+unsigned char* RadixTree<CMP>::prefix(Node* N)
+{
+    return reinterpret_cast<unsigned char*>(N) + header_size(N->type);
+}
+
+
+/** Definition of the capacity function
+
+ @param type of node
+ @return the most children a node of that type holds
+ */
+template <typename CMP>
+unsigned RadixTree<CMP>::capacity(unsigned char type)
+{
+    switch (type)
+    {
+        case NODE4: return 4;
+        case NODE16: return 16;
+        case NODE48: return 48;
+        case NODE256: return 256;
+        default: return 0;
+    }
+}
+
+
+/** Definition of the type_for function
+
+ @param count is a number of children
+ @return the smallest node type that holds them
+ */
+template <typename CMP>
+unsigned char RadixTree<CMP>::type_for(unsigned count)
+{
+    if (count == 0) return LEAF;
+    if (count <= 4) return NODE4;
+    if (count <= 16) return NODE16;
+    if (count <= 48) return NODE48;
+    return NODE256;
+}
+
+
+/** Definition of the find_child function, that looks up the child for the next byte of a key.
+
+ @param N is the node
+ @param c is the byte
+ @return the slot holding the child, or nullptr if there is none
+ */
+template <typename CMP>
+typename RadixTree<CMP>::Node** RadixTree<CMP>::find_child(Node* N, unsigned char c)
+{
+    switch (N->type)
+    {
+        case NODE4:
+        {
+            Node4* n = static_cast<Node4*>(N);
+            for (unsigned i = 0; i < n->count; ++i)
+                if (n->keys[i] == c) return &n->children[i];
+            return nullptr;
+        }
+        case NODE16:
+        {
+            Node16* n = static_cast<Node16*>(N);
+            for (unsigned i = 0; i < n->count; ++i)
+                if (n->keys[i] == c) return &n->children[i];
+            return nullptr;
+        }
+        case NODE48:
+        {
+            Node48* n = static_cast<Node48*>(N);
+            return n->index[c] ? &n->children[n->index[c] - 1] : nullptr;
+        }
+        case NODE256:
+        {
+            Node256* n = static_cast<Node256*>(N);
+            return n->children[c] ? &n->children[c] : nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+
+/** Definition of the next_child function, that finds the child with the next larger byte (or next smaller byte, going in reverse).
+
+ @param N is the node
+ @param after is the byte to start after, -1 or 256 to start from either end
+ @param reverse is true to go from larger bytes to smaller ones
+ @param byte is set to the byte of the child found
+ @return the child, or nullptr if there are no more
+ */
+template <typename CMP>
+typename RadixTree<CMP>::Node* RadixTree<CMP>::next_child(Node* N, int after, bool reverse, unsigned char& byte)
+{
+    switch (N->type)
+    {
+        case NODE4:
+        case NODE16:
+        {
+            unsigned char* keys = N->type == NODE4 ? static_cast<Node4*>(N)->keys : static_cast<Node16*>(N)->keys;
+            Node** children = N->type == NODE4 ? static_cast<Node4*>(N)->children : static_cast<Node16*>(N)->children;
+            if (!reverse)
+            {
+                for (unsigned i = 0; i < N->count; ++i)
+                    if (keys[i] > after) { byte = keys[i]; return children[i]; }
+            }
+            else
+            {
+                for (unsigned i = N->count; i-- > 0; )
+                    if (keys[i] < after) { byte = keys[i]; return children[i]; }
+            }
+            return nullptr;
+        }
+        case NODE48:
+        {
+            Node48* n = static_cast<Node48*>(N);
+            for (int c = reverse ? after - 1 : after + 1; c >= 0 && c < 256; c += reverse ? -1 : 1)
+                if (n->index[c]) { byte = static_cast<unsigned char>(c); return n->children[n->index[c] - 1]; }
+            return nullptr;
+        }
+        case NODE256:
+        {
+            Node256* n = static_cast<Node256*>(N);
+            for (int c = reverse ? after - 1 : after + 1; c >= 0 && c < 256; c += reverse ? -1 : 1)
+                if (n->children[c]) { byte = static_cast<unsigned char>(c); return n->children[c]; }
+            return nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+
+/** Definition of the for_each_child function
+
+ @param N is the node
+ @param f is called with the byte and the child, in byte order
+ */
+template <typename CMP>
+template <typename F>
+void RadixTree<CMP>::for_each_child(Node* N, F f)
+{
+    unsigned char c = 0;
+    for (Node* child = next_child(N, -1, false, c); child != nullptr; child = next_child(N, c, false, c))
+        f(c, child);
+}
+
+
+/** Definition of the add_child_raw function, that adds a child to a node with room for it. Small nodes keep their bytes sorted.
+
+ @param N is the node
+ @param c is the byte of the child
+ @param child is the child
+ */
+template <typename CMP>
+void RadixTree<CMP>::add_child_raw(Node* N, unsigned char c, Node* child)
+{
+    switch (N->type)
+    {
+        case NODE4:
+        case NODE16:
+        {
+            unsigned char* keys = N->type == NODE4 ? static_cast<Node4*>(N)->keys : static_cast<Node16*>(N)->keys;
+            Node** children = N->type == NODE4 ? static_cast<Node4*>(N)->children : static_cast<Node16*>(N)->children;
+            //shift larger bytes up to make room
+            unsigned i = N->count;
+            while (i > 0 && keys[i - 1] > c)
+            {
+                keys[i] = keys[i - 1];
+                children[i] = children[i - 1];
+                --i;
+            }
+            keys[i] = c;
+            children[i] = child;
+            break;
+        }
+        case NODE48:
+        {
+            Node48* n = static_cast<Node48*>(N);
+            unsigned slot = 0;
+            while (n->children[slot] != nullptr)
+                ++slot;
+            n->children[slot] = child;
+            n->index[c] = static_cast<unsigned char>(slot + 1);
+            break;
+        }
+        case NODE256:
+            static_cast<Node256*>(N)->children[c] = child;
+            break;
+    }
+    ++N->count;
+}
+
+
+/** Definition of the make_node function, that allocates a node with no children and copies the prefix in after its header.
+
+ @param type of node
+ @param bytes of the prefix
+ @param length of the prefix
+ @return the new node
+ */
+template <typename CMP>
+typename RadixTree<CMP>::Node* RadixTree<CMP>::make_node(unsigned char type, const unsigned char* bytes, std::size_t length)
+{
+    std::size_t header = header_size(type);
+    void* mem = ::operator new(header + length);
+    //value-initialise so every child slot starts out empty
+    Node* N;
+    switch (type)
+    {
+        case NODE4: N = ::new (mem) Node4(); break;
+        case NODE16: N = ::new (mem) Node16(); break;
+        case NODE48: N = ::new (mem) Node48(); break;
+        case NODE256: N = ::new (mem) Node256(); break;
+        default: N = ::new (mem) Node(); break;
+    }
+    N->type = type;
+    N->prefixLength = static_cast<unsigned int>(length);
+    if (length > 0)
+        std::memcpy(reinterpret_cast<unsigned char*>(mem) + header, bytes, length);
+    memoryBytes += header + length;
+    return N;
+}
+
+
+/** Definition of the remake function, that builds a node of another type or with another prefix out of N, and frees N. The prefix may point
+ into N itself.
+
+ @param N is the node to replace
+ @param type of the new node
+ @param bytes of the new prefix
+ @param length of the new prefix
+ @return the new node
+ */
+template <typename CMP>
+typename RadixTree<CMP>::Node* RadixTree<CMP>::remake(Node* N, unsigned char type, const unsigned char* bytes, std::size_t length)
+{
+    Node* fresh = make_node(type, bytes, length);
+    fresh->terminal = N->terminal;
+    for_each_child(N, [&](unsigned char c, Node* child) { add_child_raw(fresh, c, child); });
+    free_node(N);
+    return fresh;
+}
+
+
+/** Definition of the free_node function
+
+ @param N is the node to free, its children are left alone
+ */
+template <typename CMP>
+void RadixTree<CMP>::free_node(Node* N)
+{
+    memoryBytes -= header_size(N->type) + N->prefixLength;
+    ::operator delete(N);
+}
+
+
+/** Definition of the add_child function, that grows the node to the next size first if it is full.
+
+ @param ref is the slot holding the node
+ @param c is the byte of the child
+ @param child is the child
+ */
+template <typename CMP>
+void RadixTree<CMP>::add_child(Node** ref, unsigned char c, Node* child)
+{
+    Node* N = *ref;
+    if (N->count == capacity(N->type))
+        N = *ref = remake(N, type_for(N->count + 1), prefix(N), N->prefixLength);
+    add_child_raw(N, c, child);
+}
+
+
+/** Definition of the remove_child function. A node shrinks to the next size down once it is well under that size's capacity, so adding and
+ removing one child at the boundary does not keep reallocating it.
+
+ @param ref is the slot holding the node
+ @param c is the byte of the child to remove
+ */
+template <typename CMP>
+void RadixTree<CMP>::remove_child(Node** ref, unsigned char c)
+{
+    Node* N = *ref;
+    switch (N->type)
+    {
+        case NODE4:
+        case NODE16:
+        {
+            unsigned char* keys = N->type == NODE4 ? static_cast<Node4*>(N)->keys : static_cast<Node16*>(N)->keys;
+            Node** children = N->type == NODE4 ? static_cast<Node4*>(N)->children : static_cast<Node16*>(N)->children;
+            unsigned i = 0;
+            while (keys[i] != c)
+                ++i;
+            for (; i + 1 < N->count; ++i)
+            {
+                keys[i] = keys[i + 1];
+                children[i] = children[i + 1];
+            }
+            children[N->count - 1] = nullptr;
+            break;
+        }
+        case NODE48:
+        {
+            Node48* n = static_cast<Node48*>(N);
+            n->children[n->index[c] - 1] = nullptr;
+            n->index[c] = 0;
+            break;
+        }
+        case NODE256:
+            static_cast<Node256*>(N)->children[c] = nullptr;
+            break;
+    }
+    --N->count;
+
+    bool shrink = (N->type == NODE256 && N->count <= 40) || (N->type == NODE48 && N->count <= 12) ||
+                  (N->type == NODE16 && N->count <= 3) || (N->type == NODE4 && N->count == 0 && N->terminal);
+    if (shrink)
+        *ref = remake(N, type_for(N->count), prefix(N), N->prefixLength);
+}
+
+
+/** Definition of the copy_helper function, that copies a node and recursively its children.
+
+ @param N is the root of the subtree to copy
+ @return the root of the copy
+ */
+template <typename CMP>
+typename RadixTree<CMP>::Node* RadixTree<CMP>::copy_helper(Node* N)
+{
+    if (N == nullptr) return nullptr;
+    Node* fresh = make_node(N->type, prefix(N), N->prefixLength);
+    fresh->terminal = N->terminal;
+    for_each_child(N, [&](unsigned char c, Node* child) { add_child_raw(fresh, c, copy_helper(child)); });
+    return fresh;
+}
+
+
+/** Definition of the destroy function, that frees the children of a node recursively and then the node itself.
+
+ @param N is the root of the subtree to free
+ */
+template <typename CMP>
+void RadixTree<CMP>::destroy(Node* N)
+{
+    if (N == nullptr) return;
+    for_each_child(N, [&](unsigned char, Node* child) { destroy(child); });
+    free_node(N);
+}
+
+
+/** Definition of ++ as a prefix operator, that moves to the next key in order.
+
+ @return reference to this iterator
+ */
+template <typename CMP>
+typename RadixTree<CMP>::iterator& RadixTree<CMP>::iterator::operator++()
+{
+    advance();
+    return *this;
+}
+
+
+/** Definition of ++ as a postfix operator
+
+ @return a copy of the iterator before it moved
+ */
+template <typename CMP>
+typename RadixTree<CMP>::iterator RadixTree<CMP>::iterator::operator++(int)
+{
+    iterator previous = *this;
+    advance();
+    return previous;
+}
+
+
+/** Definition of * operator
+
+ @return reference to the current key
+ */
+template <typename CMP>
+const std::string& RadixTree<CMP>::iterator::operator*() const
+{
+    return key;
+}
+
+
+/** Definition of -> operator
+
+ @return pointer to the current key
+ */
+template <typename CMP>
+const std::string* RadixTree<CMP>::iterator::operator->() const
+{
+    return &key;
+}
+
+
+/** Definition of == operator, two iterators are equal if both are at the end, or both are at the same key.
+
+ @return true if the iterators are at the same position
+ */
+template <typename CMP>
+bool RadixTree<CMP>::iterator::operator==(const iterator& other) const
+{
+    if (path.empty() || other.path.empty())
+        return path.empty() == other.path.empty();
+    return path.back().node == other.path.back().node && key == other.key;
+}
+
+
+/** Definition of != operator
+
+ @return true if the iterators are at different positions
+ */
+template <typename CMP>
+bool RadixTree<CMP>::iterator::operator!=(const iterator& other) const
+{
+    return !(*this == other);
+}
+
+
+/** Definition of the push function, that starts a frame for a node. Its prefix is added to the key once the frame is started.
+
+ @param N is the node
+ @param base is the length of the key before the node's prefix
+ */
+template <typename CMP>
+void RadixTree<CMP>::iterator::push(Node* N, std::size_t base)
+{
+    Frame frame;
+    frame.node = N;
+    frame.base = base;
+    frame.last = reversed ? 256 : -1;
+    frame.started = false;
+    frame.terminalDone = false;
+    path.push_back(frame);
+    key.resize(base);
+    key.append(reinterpret_cast<char*>(prefix(N)), N->prefixLength);
+}
+
+
+/** Definition of the advance function. It is a depth first walk over the path: in std::less order a node's own key comes before its children,
+ and in std::greater order it comes after them, with the children in reverse byte order.
+ */
+template <typename CMP>
+void RadixTree<CMP>::iterator::advance()
+{
+    while (!path.empty())
+    {
+        Frame& frame = path.back();
+        std::size_t node_end = frame.base + frame.node->prefixLength;
+        if (!frame.started)
+        {
+            frame.started = true;
+            if (!reversed && frame.node->terminal)
+            {
+                key.resize(node_end);
+                return;
+            }
+        }
+
+        //go down into the next child
+        unsigned char c = 0;
+        Node* child = next_child(frame.node, frame.last, reversed, c);
+        if (child != nullptr)
+        {
+            frame.last = c;
+            key.resize(node_end);
+            key.push_back(static_cast<char>(c));
+            push(child, node_end + 1);
+            continue;
+        }
+
+        //children are done, in reverse order the node's own key comes now
+        if (reversed && frame.node->terminal && !frame.terminalDone)
+        {
+            frame.terminalDone = true;
+            key.resize(node_end);
+            return;
+        }
+        path.pop_back();
+    }
+    key.clear();
+}
+
+
+#endif /* RadixTree_h */
@@ -0,0 +1,180 @@
+/** @file RecordingSearchTree.h
+ @brief Contains the class declarations and definitions for a RecordingSearchTree templated class, a BinarySearchTree that can log its operations.
+
+ A RecordingSearchTree passes every call on to the BinarySearchTree it holds. Between start_recording and stop_recording it also appends each
+ insert, erase, find (or contains) and begin (a walk over the tree) with its key to a trace file (see TreeTrace.h), which the replay program
+ can run against any of the tree variants. While not recording the only cost is checking whether a trace is open.
+ */
+
+#ifndef RecordingSearchTree_h
+#define RecordingSearchTree_h
+#include "BinarySearchTree.h"
+#include "TreeTrace.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+
+template <typename T,typename CMP=std::less<T>,typename AUG=NoSummary>
+class RecordingSearchTree
+{
+public:
+    //start logging operations to a new trace file at path
+    void start_recording(const std::string& path);
+    //stop logging and close the trace file
+    void stop_recording();
+    //true while operations are being logged
+    bool recording() const;
+    //insert element into tree
+    void insert(T data);
+    //remove element
+    void erase(T data);
+    //find element, returns end() if it is not in the tree
+    TreeIterator<T,CMP,AUG> find(const T& data);
+    //check whether data is in the tree, recorded as a find
+    bool contains(const T& data);
+    //access iterator to the smallest value, recorded as a walk over the tree
+    TreeIterator<T,CMP,AUG> begin();
+    //access iterator to one after the largest value
+    TreeIterator<T,CMP,AUG> end();
+    //number of values in the tree
+    std::size_t size() const;
+    //the tree itself, calls made on it directly are not recorded
+    BinarySearchTree<T,CMP,AUG>& tree();
+
+private:
+    //tree the calls are passed on to
+    BinarySearchTree<T,CMP,AUG> wrapped;
+    //trace being written
+    TraceWriter<T,CMP> trace;
+};
+
+
+/** Definition of the start_recording function, that replaces any trace being recorded.
+
+ @param path of the trace file, which is created or truncated
+ @throws std::system_error if the file can't be created
+ */
+template <typename T,typename CMP,typename AUG>
+void RecordingSearchTree<T,CMP,AUG>::start_recording(const std::string& path)
+{
+    trace.open(path);
+}
+
+
+/** Definition of the stop_recording function
+
+ @throws std::system_error if the rest of the trace can't be written
+ */
+template <typename T,typename CMP,typename AUG>
+void RecordingSearchTree<T,CMP,AUG>::stop_recording()
+{
+    trace.close();
+}
+
+
+/** Definition of the recording function
+
+ @return true while operations are being logged
+ */
+template <typename T,typename CMP,typename AUG>
+bool RecordingSearchTree<T,CMP,AUG>::recording() const
+{
+    return trace.is_open();
+}
+
+
+/** Definition of the insert function
+
+ @param value you want to insert
+ */
+template <typename T,typename CMP,typename AUG>
+void RecordingSearchTree<T,CMP,AUG>::insert(T data)
+{
+    if (trace.is_open()) trace.record(TraceOp::insert, data);
+    wrapped.insert(std::move(data));
+}
+
+
+/** Definition of the erase function
+
+ @param value you want to remove
+ */
+template <typename T,typename CMP,typename AUG>
+void RecordingSearchTree<T,CMP,AUG>::erase(T data)
+{
+    if (trace.is_open()) trace.record(TraceOp::erase, data);
+    wrapped.erase(std::move(data));
+}
+
+
+/** Definition of the find function
+
+ @param value you want to look up
+ @return a TreeIterator to the value, or end() if it is not in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> RecordingSearchTree<T,CMP,AUG>::find(const T& data)
+{
+    if (trace.is_open()) trace.record(TraceOp::find, data);
+    return wrapped.find(data);
+}
+
+
+/** Definition of the contains function
+
+ @param value you want to look up
+ @return true if the value is in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+bool RecordingSearchTree<T,CMP,AUG>::contains(const T& data)
+{
+    if (trace.is_open()) trace.record(TraceOp::find, data);
+    return wrapped.contains(data);
+}
+
+
+/** Definition of the begin() function. Starting to iterate is recorded as a walk over the whole tree, since that is what range-for does.
+
+ @return a TreeIterator to the smallest value in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> RecordingSearchTree<T,CMP,AUG>::begin()
+{
+    if (trace.is_open()) trace.record(TraceOp::iterate);
+    return wrapped.begin();
+}
+
+
+/** Definition of the end() function
+
+ @return a TreeIterator to one after the largest value in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> RecordingSearchTree<T,CMP,AUG>::end()
+{
+    return wrapped.end();
+}
+
+
+/** Definition of the size function
+
+ @return the number of values in the tree
+ */
+template <typename T,typename CMP,typename AUG>
+std::size_t RecordingSearchTree<T,CMP,AUG>::size() const
+{
+    return wrapped.size();
+}
+
+
+/** Definition of the tree function
+
+ @return the tree the calls are passed on to
+ */
+template <typename T,typename CMP,typename AUG>
+BinarySearchTree<T,CMP,AUG>& RecordingSearchTree<T,CMP,AUG>::tree()
+{
+    return wrapped;
+}
+
+#endif /* RecordingSearchTree_h */
@@ -0,0 +1,220 @@
+/** @file StaticSearchTree.h
+ @brief Contains the class declarations and definitions for a StaticSearchTree templated class, a fixed set of values that can be built at compile time.
+
+ A StaticSearchTree<T,CMP,N> holds at most N values in one sorted array. Every member function is constexpr, so a tree declared constexpr
+ is sorted, stripped of repeats and laid out by the compiler, and ends up in read-only data with nothing left to do at startup:
+
+     constexpr StaticSearchTree<std::string_view, std::less<std::string_view>, 3> reserved = {"for", "if", "while"};
+     constexpr auto codes = make_static_tree<int>({404, 200, 500});
+
+ As in BinarySearchTree, values are ordered by CMP, the first of several equal values is kept, and begin()/end() iterate in order, so the
+ tree works in a range-for. find and lower_bound do a branch-free binary search. For the compile-time version T has to be a literal type with
+ a default constructor (integers, enums, std::string_view, small structs) and CMP has to be callable in constant expressions, as std::less is.
+ */
+
+#ifndef StaticSearchTree_h
+#define StaticSearchTree_h
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+template <typename T,typename CMP,std::size_t N>
+class StaticSearchTree
+{
+public:
+    typedef const T* iterator;
+
+    //constructor for an empty tree
+    constexpr StaticSearchTree();
+    //constructor that sorts the values and drops repeats, throws if there are more than N
+    constexpr StaticSearchTree(std::initializer_list<T> init);
+    //constructor that sorts the values of an array and drops repeats
+    constexpr explicit StaticSearchTree(const T (&init)[N]);
+    //find element, returns end() if it is not in the tree
+    constexpr iterator find(const T& data) const;
+    //check whether data is in the tree
+    constexpr bool contains(const T& data) const;
+    //find the first element not less than data, returns end() if there is none
+    constexpr iterator lower_bound(const T& data) const;
+    //access iterators to the smallest value and one after the largest value
+    constexpr iterator begin() const;
+    constexpr iterator end() const;
+    //number of values in the tree
+    constexpr std::size_t size() const;
+
+private:
+    //sort the first count values and drop repeats
+    constexpr void sort_values();
+    //values in order, only the first count are used
+    std::array<T,N> values;
+    //number of values in the tree
+    std::size_t count;
+    //to compare data based on specified comparator
+    CMP isless;
+};
+
+
+/** Builds a StaticSearchTree with room for exactly the values given, so N does not have to be written out: make_static_tree<int>({3, 1, 2}).
+
+ @param values to put in the tree
+ @return the tree holding the values
+ */
+template <typename T,typename CMP=std::less<T>,std::size_t N>
+constexpr StaticSearchTree<T,CMP,N> make_static_tree(const T (&values)[N])
+{
+    return StaticSearchTree<T,CMP,N>(values);
+}
+
+
+/** Definition of the standard constructor, for a tree without values.
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr StaticSearchTree<T,CMP,N>::StaticSearchTree() : values(), count(0), isless()
+{
+}
+
+
+/** Definition of the initializer list constructor, that copies the values in and sorts them. In a constant expression the throw turns a list
+ that is too long into a compile error.
+
+ @param init holds the values to put in the tree, in any order
+ @throws std::length_error if there are more than N values
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr StaticSearchTree<T,CMP,N>::StaticSearchTree(std::initializer_list<T> init) : values(), count(0), isless()
+{
+    if (init.size() > N) throw std::length_error("StaticSearchTree holds fewer values than it was given");
+    for (const T& value : init)
+        values[count++] = value;
+    sort_values();
+}
+
+
+/** Definition of the array constructor, that copies the values in and sorts them.
+
+ @param init holds the values to put in the tree, in any order
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr StaticSearchTree<T,CMP,N>::StaticSearchTree(const T (&init)[N]) : values(), count(0), isless()
+{
+    for (std::size_t i = 0; i < N; ++i)
+        values[count++] = init[i];
+    sort_values();
+}
+
+
+/** Definition of the sort_values function. std::sort is not constexpr before C++20, so this is an insertion sort, which is fine for
+ tables written out by hand. It is stable, so the first of several equal values comes first and is the one kept.
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr void StaticSearchTree<T,CMP,N>::sort_values()
+{
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        T value = values[i];
+        std::size_t j = i;
+        while (j > 0 && isless(value, values[j - 1]))
+        {
+            values[j] = values[j - 1];
+            --j;
+        }
+        values[j] = value;
+    }
+    //keep the first of each run of equal values
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (kept == 0 || isless(values[kept - 1], values[i]))
+            values[kept++] = values[i];
+    }
+    count = kept;
+}
+
+
+/** Definition of the lower_bound function. Each step halves the range, moving base forward by half when the value before the middle is less
+ than data. The comparison result is multiplied in rather than picked with ?:, which compilers tend to turn into a branch that is mispredicted
+ half the time.
+
+ @param value you want to look up
+ @return iterator to the first value not less than data, or end() if there is none
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr typename StaticSearchTree<T,CMP,N>::iterator StaticSearchTree<T,CMP,N>::lower_bound(const T& data) const
+{
+    if (count == 0) return end();
+    const T* base = values.data();
+    std::size_t length = count;
+    while (length > 1)
+    {
+        std::size_t half = length / 2;
+        base += static_cast<std::size_t>(isless(base[half - 1], data)) * half;
+        length -= half;
+    }
+    return isless(*base, data) ? base + 1 : base;
+}
+
+
+/** Definition of the find function, that searches the tree for a value.
+
+ @param value you want to look up
+ @return iterator to the value, or end() if it is not in the tree
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr typename StaticSearchTree<T,CMP,N>::iterator StaticSearchTree<T,CMP,N>::find(const T& data) const
+{
+    iterator it = lower_bound(data);
+    //lower_bound stops at the first value not less than data, which is data unless data is less than it
+    if (it == end() || isless(data, *it)) return end();
+    return it;
+}
+
+
+/** Definition of the contains function.
+
+ @param value you want to look up
+ @return true if the value is in the tree
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr bool StaticSearchTree<T,CMP,N>::contains(const T& data) const
+{
+    return find(data) != end();
+}
+
+
+/** Definition of the begin() function
+
+ @return iterator to the smallest value, or end() if the tree is empty
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr typename StaticSearchTree<T,CMP,N>::iterator StaticSearchTree<T,CMP,N>::begin() const
+{
+    return values.data();
+}
+
+
+/** Definition of the end() function
+
+ @return iterator to one after the largest value
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr typename StaticSearchTree<T,CMP,N>::iterator StaticSearchTree<T,CMP,N>::end() const
+{
+    return values.data() + count;
+}
+
+
+/** Definition of the size function
+
+ @return the number of values in the tree, after repeats were dropped
+ */
+template <typename T,typename CMP,std::size_t N>
+constexpr std::size_t StaticSearchTree<T,CMP,N>::size() const
+{
+    return count;
+}
+
+
+#endif /* StaticSearchTree_h */
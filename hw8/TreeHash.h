@@ -0,0 +1,25 @@
+/** @file TreeHash.h
+ @brief Contains the TreeHash trait, that hashes values of a BinarySearchTree consistently with its comparator.
+
+ Structures kept alongside a tree, like its Bloom filter, need equal values to hash the same. Two values are equal in a BinarySearchTree<T,CMP>
+ when neither is less than the other according to CMP, which is not always operator== (PointOrderx only looks at x, for example). So the hash
+ depends on the comparator too. The general version uses std::hash<T>, which is right whenever CMP's equality means ==, as it does for
+ std::less and std::greater. Comparators that look at only part of a value specialise TreeHash next to their definition (see comparators.h).
+ */
+
+#ifndef TreeHash_h
+#define TreeHash_h
+#include <cstddef>
+#include <functional>
+
+/**@struct TreeHash
+	@brief Hashes a value of type T so that values equal under CMP get the same hash.
+ */
+template <typename T,typename CMP>
+struct TreeHash
+{
+    //hash of value
+    std::size_t operator()(const T& value) const { return std::hash<T>()(value); }
+};
+
+#endif /* TreeHash_h */
@@ -5,6 +5,7 @@
  
  The TreeIterator overloads all necessary operators so that it can function as a bidirectional iterator for the BinarySearchTree. 
  The TreeIterator accesses TreeNodes with data type T and also keeps track of the comparator being used to compare node values
+ Nodes that were erased in lazy erase mode (tombstones) are stepped over, so iterating only ever visits values that are in the tree.
  */
 
 #ifndef TreeIterator_h
@@ -14,43 +15,46 @@
 #include <utility>
 
 //forward declarations of the BinarySearch Tree so compiler knows it is templated
-template <typename T,typename CMP> class BinarySearchTree;
+template <typename T,typename CMP,typename AUG> class BinarySearchTree;
 
 //forward declarations of the friend == operators compiler knows it is templated
-template <typename T,typename CMP>
-bool operator==(TreeIterator<T,CMP> a, TreeIterator<T,CMP> b);
+template <typename T,typename CMP,typename AUG>
+bool operator==(TreeIterator<T,CMP,AUG> a, TreeIterator<T,CMP,AUG> b);
 
 //forward declarations of the friend != operators compiler knows it is templated
-template <typename T,typename CMP>
-bool operator!=(TreeIterator<T,CMP> a, TreeIterator<T,CMP> b);
+template <typename T,typename CMP,typename AUG>
+bool operator!=(TreeIterator<T,CMP,AUG> a, TreeIterator<T,CMP,AUG> b);
 
 
-template <typename T,typename CMP>
+template <typename T,typename CMP,typename AUG>
 class TreeIterator {
 
 public:
     //prefix next largest node operator
-    TreeIterator<T,CMP>& operator++();
+    TreeIterator<T,CMP,AUG>& operator++();
     //postfix next largest node operator
-    TreeIterator<T,CMP> operator++(int);
+    TreeIterator<T,CMP,AUG> operator++(int);
     //prefix next smallest node operator
-    TreeIterator<T,CMP>& operator--();
+    TreeIterator<T,CMP,AUG>& operator--();
 	//postfix next smallest node operator
-	TreeIterator<T,CMP> operator--(int);
-    //retrieve value of node
-    T operator*();
-    //retrieve value of node
-    T operator->();
+	TreeIterator<T,CMP,AUG> operator--(int);
+    //access value of node
+    T& operator*();
+    //access members of the node's value
+    T* operator->();
     //comparison operators
-    friend bool operator==<>(TreeIterator<T,CMP> a, TreeIterator<T,CMP> b);
-    friend bool operator!=<>(TreeIterator<T,CMP> a, TreeIterator<T,CMP> b);
+    friend bool operator==<>(TreeIterator<T,CMP,AUG> a, TreeIterator<T,CMP,AUG> b);
+    friend bool operator!=<>(TreeIterator<T,CMP,AUG> a, TreeIterator<T,CMP,AUG> b);
 
     
 private:
     //pointer to current node
-    TreeNode<T,CMP>* node;
+    TreeNode<T,CMP,AUG>* node;
+    //in-order neighbours of a node, tombstones included
+    static TreeNode<T,CMP,AUG>* next_node(TreeNode<T,CMP,AUG>* node);
+    static TreeNode<T,CMP,AUG>* prev_node(TreeNode<T,CMP,AUG>* node);
     //declare friend class
-    friend class BinarySearchTree<T,CMP>;
+    friend class BinarySearchTree<T,CMP,AUG>;
 
 
 };
@@ -61,14 +65,31 @@ private:
  @return a reference to the original tree iterator with its node pointer now pointing at the next largest element of the tree
  
  */
-template <typename T,typename CMP>
-TreeIterator<T,CMP>& TreeIterator<T,CMP>::operator++()
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG>& TreeIterator<T,CMP,AUG>::operator++()
+{
+    //move to the next node, stepping over tombstones
+    do node=next_node(node);
+    while(node!=nullptr&&node->erased);
+    return *this;
+}
+
+
+/** Definition of the next_node function, that finds the next largest node in the tree using the in-order algorithm. Tombstones are not skipped here,
+ the tree uses this to walk the nodes that are physically linked.
+ 
+ @param node to start from
+ @return the next node in order (the endNode after the largest node)
+ 
+ */
+template <typename T,typename CMP,typename AUG>
+TreeNode<T,CMP,AUG>* TreeIterator<T,CMP,AUG>::next_node(TreeNode<T,CMP,AUG>* node)
 {
     
     //have a pointer to the current node
-    TreeNode<T,CMP>* cur=node;
+    TreeNode<T,CMP,AUG>* cur=node;
     //and a pointer to the parent
-    TreeNode<T,CMP>*parent2=node->parent;
+    TreeNode<T,CMP,AUG>*parent2=node->parent;
     //if the node doesnt have a right subtree
     if(node->right==nullptr)
     {
@@ -78,9 +99,8 @@ TreeIterator<T,CMP>& TreeIterator<T,CMP>::operator++()
             cur=parent2;
             parent2=parent2->parent;
         }
-        //set the new iterator node to be parent of that node
-        node=parent2;
-        return *this;
+        //the next node is the parent of that node
+        return parent2;
     }
     //if the node has a right subtree
     else
@@ -92,9 +112,8 @@ TreeIterator<T,CMP>& TreeIterator<T,CMP>::operator++()
         {
             cur=cur->left;
         }
-        //set new iterator node to the smallest element of right subtree
-        node=cur;
-        return *this;
+        //the next node is the smallest element of right subtree
+        return cur;
     }
     
 }
@@ -105,11 +124,11 @@ TreeIterator<T,CMP>& TreeIterator<T,CMP>::operator++()
  @return a copy of the original TreeIterator before it was incremented.
  
  */
-template <typename T,typename CMP>
-TreeIterator<T,CMP> TreeIterator<T,CMP>::operator++(int)
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> TreeIterator<T,CMP,AUG>::operator++(int)
 {
     //create a temporary TreeIterator to hold the Iterators current position
-    TreeIterator<T,CMP> previous=(*this);
+    TreeIterator<T,CMP,AUG> previous=(*this);
     //increment original iterator
     ++(*this);
     //return an iterator to the original position
@@ -119,28 +138,44 @@ TreeIterator<T,CMP> TreeIterator<T,CMP>::operator++(int)
 
 /** Definition of -- as a prefix operator, for example, this function is called like so: --iterator. It uses the reverse in-order algorithm to move to the next smallest node in the tree.
  
- @return a copy of the original TreeIterator before it was decremented.
+ @return a reference to the original tree iterator with its node pointer now pointing at the next smallest element of the tree
+ 
+ */
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG>& TreeIterator<T,CMP,AUG>::operator--()
+{
+    //move to the previous node, stepping over tombstones
+    do node=prev_node(node);
+    while(node!=nullptr&&node->erased);
+    return *this;
+}
+
+
+/** Definition of the prev_node function, that finds the next smallest node in the tree using the reverse in-order algorithm. Tombstones are not skipped here.
+ 
+ @param node to start from
+ @return the previous node in order, or nullptr if node is the smallest
  
  */
-template <typename T,typename CMP>
-TreeIterator<T,CMP>& TreeIterator<T,CMP>::operator--()
+template <typename T,typename CMP,typename AUG>
+TreeNode<T,CMP,AUG>* TreeIterator<T,CMP,AUG>::prev_node(TreeNode<T,CMP,AUG>* node)
 {
     
     //have a pointer to the current node
-    TreeNode<T,CMP>* cur=node;
+    TreeNode<T,CMP,AUG>* cur=node;
     //have a pointer to the parent
-    TreeNode<T,CMP>* parent2=node->parent;
+    TreeNode<T,CMP,AUG>* parent2=node->parent;
     //if the node has a left subtree
     if(node->left!=nullptr)
     {
         //get the largest element of the left subtree
+        cur=node->left;
         while(cur->right!=nullptr)
         {
             cur=cur->right;
         }
-        //set the new iterator node to the largest element of the left subtree
-        node=cur;
-        return *this;
+        //the previous node is the largest element of the left subtree
+        return cur;
     }
     //if the node does not have a left subtree, traverse upwards until you reach the first node that is a right child
     while(parent2!=nullptr&&cur==parent2->left)
@@ -149,9 +184,8 @@ TreeIterator<T,CMP>& TreeIterator<T,CMP>::operator--()
         parent2=parent2->parent;
         
     }
-    //set the current iterator node to the parent of that node
-    node=parent2;
-    return *this;
+    //the previous node is the parent of that node
+    return parent2;
     
 }
 
@@ -161,11 +195,11 @@ TreeIterator<T,CMP>& TreeIterator<T,CMP>::operator--()
  @return a reference to the original tree iterator with its node pointer now pointing at the next smallest element of the tree
  
  */
-template <typename T,typename CMP>
-TreeIterator<T,CMP> TreeIterator<T,CMP>::operator--(int)
+template <typename T,typename CMP,typename AUG>
+TreeIterator<T,CMP,AUG> TreeIterator<T,CMP,AUG>::operator--(int)
 {
     //save current position
-    TreeIterator<T,CMP> old=(*this);
+    TreeIterator<T,CMP,AUG> old=(*this);
     //decrement iterator
     --(*this);
     //return old position
@@ -175,10 +209,10 @@ TreeIterator<T,CMP> TreeIterator<T,CMP>::operator--(int)
 
 /** Definition of * operator, so that we can reference the value of the node that the iterator is currently pointing to.
  
- @return the integer value of the current node
+ @return reference to the value of the current node
  */
-template <typename T,typename CMP>
-T TreeIterator<T,CMP>::operator*()
+template <typename T,typename CMP,typename AUG>
+T& TreeIterator<T,CMP,AUG>::operator*()
 {
     //return current value of node
     return node->data;
@@ -186,15 +220,15 @@ T TreeIterator<T,CMP>::operator*()
 }
 
 
-/** Definition of -> operator, so that we can reference the value of the node that the iterator is currently pointing to.
+/** Definition of -> operator, so that we can reference the members of the value of the node that the iterator is currently pointing to.
  
- @return the integer value of the current node
+ @return pointer to the value of the current node
  */
-template <typename T,typename CMP>
-T TreeIterator<T,CMP>::operator->()
+template <typename T,typename CMP,typename AUG>
+T* TreeIterator<T,CMP,AUG>::operator->()
 {
-    //return current value of node
-    return node->data;
+    //return address of current value of node
+    return &node->data;
     
 }
 
@@ -203,8 +237,8 @@ T TreeIterator<T,CMP>::operator->()
  
  @return boolean value, true if the two iterators are pointing to the same node
  */
-template <typename T,typename CMP>
-bool operator==(TreeIterator<T,CMP> a, TreeIterator<T,CMP> b)
+template <typename T,typename CMP,typename AUG>
+bool operator==(TreeIterator<T,CMP,AUG> a, TreeIterator<T,CMP,AUG> b)
 {
     //return true if pointing to same node
     return(a.node==b.node);
@@ -215,8 +249,8 @@ bool operator==(TreeIterator<T,CMP> a, TreeIterator<T,CMP> b)
  
  @return boolean value, true if the two iterators are not pointing to the same node
  */
-template <typename T,typename CMP>
-bool operator!=(TreeIterator<T,CMP> a, TreeIterator<T,CMP> b)
+template <typename T,typename CMP,typename AUG>
+bool operator!=(TreeIterator<T,CMP,AUG> a, TreeIterator<T,CMP,AUG> b)
 {
     //return false if pointing to same node
     if (a.node==b.node) return false;
@@ -4,31 +4,39 @@
  @date Febuary 11th, 2016
  
 The TreeNode class serves as the nodes in our BinarySearchTree. It holds an integer as well as pointers to the left, right, and parent nodes 
-in the binary search tree. It allows both the BinarySearchTree and TreeIterator to be its friend. 
+in the binary search tree. It allows the BinarySearchTree, TreeIterator and HashIndex to be its friend. 
+Nodes do not keep a reference back to their tree, so a tree can be moved or swapped without touching its nodes. Linking new nodes into
+the tree is done by the BinarySearchTree itself.
 The TreeNode is templated to hold data of type T, and hold a comparator of type CMP (which will be the default less than comparator
 if not provided.
+The third parameter AUG is a summary policy (see TreeSummary.h). The node inherits the summary of its subtree from SummarySlot<AUG>, which is
+empty for the default NoSummary, so plain trees pay nothing for it.
  
  */
 
 #ifndef TreeNode_h
 #define TreeNode_h
+#include <iostream>
+#include <functional>
+#include <utility>
+#include "TreeSummary.h"
 
 //forward declarations of the BinarySearch Tree so compiler knows it is templated
-template <typename T,typename CMP> class BinarySearchTree;
+template <typename T,typename CMP,typename AUG> class BinarySearchTree;
 //forward declarations of the TreeIterator so compiler knows it is templated
-template <typename T,typename CMP> class TreeIterator;
+template <typename T,typename CMP,typename AUG=NoSummary> class TreeIterator;
+//forward declarations of the HashIndex, which reads the data of the nodes it holds
+template <typename T,typename CMP,typename AUG> class HashIndex;
 
-template<typename T,typename CMP=std::less<T>>
-class TreeNode
+template<typename T,typename CMP=std::less<T>,typename AUG=NoSummary>
+class TreeNode : private SummarySlot<AUG>
 {
 public:
-    TreeNode(BinarySearchTree<T,CMP>& parent):myBst(parent){};
-    //insert node into correct position
-    void insert_node(TreeNode<T,CMP>* new_node);
-    //print all nodes
-    void print_nodes() const;
+    //construct the node's data in place from the given arguments
+    template <typename... Args>
+    TreeNode(Args&&... args):data(std::forward<Args>(args)...),left(nullptr),right(nullptr),parent(nullptr),erased(false){};
     //find specified value in tree
-    bool find(T value) const;
+    bool find(const T& value, const TreeNode* end) const;
   
 private:
     //to compare data based on specified comparator
@@ -39,63 +47,22 @@ private:
     TreeNode* left;
     TreeNode* right;
     TreeNode* parent;
+    //true if the node was erased in lazy erase mode and is only kept as a tombstone
+    bool erased;
     //friend classes
-    friend class BinarySearchTree<T,CMP>;
-    friend class TreeIterator<T,CMP>;
-    //reference to the tree that the node is a part of 
-    BinarySearchTree <T,CMP>& myBst;
+    friend class BinarySearchTree<T,CMP,AUG>;
+    friend class TreeIterator<T,CMP,AUG>;
+    friend class HashIndex<T,CMP,AUG>;
 };
 
 
-#include <iostream>
-
-/** Definition of the insert_node function, that takes a pointer to another treeNode and adds it into the tree in the correct sorted position
- 
- @param pointer to the TreeNode that we want to add to the tree
- 
- */
-template<typename T,typename CMP>
-void TreeNode<T,CMP>::insert_node(TreeNode<T,CMP>* new_node)
-{
-    //if the data we want to insert is less than the current node's data
-    if (isless(new_node->data, data))
-    {
-        //and the current nodes left child is empty
-        if (left == NULL)
-        {
-            //add the new node in
-            new_node->parent=this;
-            left=new_node;
-        }
-        //if the current node has a left child, traverse the left side of the tree
-        else left->insert_node(new_node);
-    }
-    //if the data we want to insert is greater than the current node's data
-    else if (isless(data,new_node->data))
-    {
-        //and the current nodes right child is empty
-        if (right == myBst.endNode)
-        {
-            //add the new node in
-            new_node->parent=this;
-            right = new_node;
-            //link correctly and uodate the endNode
-            new_node->right=myBst.endNode;
-            myBst.endNode->data=new_node->data;
-            myBst.endNode->parent=new_node;
-        }
-        //if the current node has a right child, traverse the right side of the tree
-        else right->insert_node(new_node);
-    }
-}
-
-
 /** Definition of the find function, that traverses the tree to check if it contains an inputed value
- @param int that we want to see if it exists in the tree
+ @param value that we want to see if it exists in the tree
+ @param end is the endNode of the tree, which holds no data and must not be compared against
  
  */
-template<typename T,typename CMP>
-bool TreeNode<T,CMP>::find(T value) const
+template<typename T,typename CMP,typename AUG>
+bool TreeNode<T,CMP,AUG>::find(const T& value, const TreeNode* end) const
 {
     //if the value we want to find is less than the current nodes data
     if (isless(value,data))
@@ -103,35 +70,19 @@ bool TreeNode<T,CMP>::find(T value) const
         //return false if there is no node less than
         if (left == NULL) return false;
         //traverse the left side of the tree otherwise
-        else return left->find(value);
+        else return left->find(value,end);
     }
     //if the value we want to find is greater than the current nodes data
     else if (isless(data,value))
     {
-        //return false if there is no right side
-        if (right == NULL) return false;
+        //return false if there is no right side (the endNode does not count)
+        if (right == NULL || right == end) return false;
         //traverse the right side otherwise
-        else return right->find(value);
+        else return right->find(value,end);
     }
     else
-        //if the value is equal to current nodes data, return true
-        return true;
-}
-
-
-/** Definition of the print_nodes function, that recursively prints out all elements after the starting root
- 
- */
-template<typename T,typename CMP>
-void TreeNode<T,CMP>::print_nodes() const
-{
-    //recursively print left side
-    if (left != NULL)
-        left->print_nodes();
-    std::cout << data << "\n";
-    //recursively print right side
-    if (right != NULL)
-        right->print_nodes();
+        //if the value is equal to current nodes data, return true unless it is a tombstone
+        return !erased;
 }
 
 
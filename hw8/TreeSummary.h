@@ -0,0 +1,93 @@
+/** @file TreeSummary.h
+ @brief Contains the summary policies a BinarySearchTree can keep in its nodes to answer range aggregates with aggregate(lo, hi).
+
+ A summary policy describes a monoid over the values of the tree. It is a class with
+    summary_type                        the type of a summary
+    static summary_type identity()      the summary of no values, which combine leaves unchanged
+    static summary_type from_value(v)   the summary of a single value
+    static summary_type combine(a, b)   the summary of the values of a followed by the values of b (must be associative)
+ Every node stores the summary of its subtree, and the tree keeps these up to date through insert, erase, tombstones, splay rotations and
+ rebuilds. combine does not need to be commutative, since values are always combined in order. Changing a value through an iterator in a way
+ that changes its summary is not noticed, so only do that with NoSummary.
+
+ NoSummary is the default and keeps nothing: nodes get no extra field, and the tree compiles the upkeep away. Point2D.h has a bounding box policy.
+ */
+
+#ifndef TreeSummary_h
+#define TreeSummary_h
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+/**@struct NoSummary
+	@brief The default policy, which keeps no summary.
+ */
+struct NoSummary
+{
+    struct summary_type {};
+    static summary_type identity() { return summary_type(); }
+    template <typename T>
+    static summary_type from_value(const T&) { return summary_type(); }
+    static summary_type combine(summary_type, summary_type) { return summary_type(); }
+};
+
+
+/**@struct SummarySlot
+	@brief Holds the summary of a node. TreeNode inherits from it, so the empty version for NoSummary takes no space.
+ */
+template <typename AUG>
+struct SummarySlot
+{
+    //summary of the node's subtree
+    typename AUG::summary_type summary;
+};
+
+template <>
+struct SummarySlot<NoSummary>
+{
+};
+
+
+/**@struct SumSummary
+	@brief Sum of the values, accumulated in S (T by default)
+ */
+template <typename T,typename S=T>
+struct SumSummary
+{
+    typedef S summary_type;
+    static summary_type identity() { return S(); }
+    static summary_type from_value(const T& value) { return S(value); }
+    static summary_type combine(const summary_type& a, const summary_type& b) { return a + b; }
+};
+
+
+/**@struct MinMaxSummary
+	@brief Smallest and largest value by operator<, the identity being (largest possible T, smallest possible T) so that it is empty.
+ T must be an arithmetic type, or specialise std::numeric_limits.
+ */
+template <typename T>
+struct MinMaxSummary
+{
+    typedef std::pair<T,T> summary_type;
+    static summary_type identity() { return summary_type(std::numeric_limits<T>::max(), std::numeric_limits<T>::lowest()); }
+    static summary_type from_value(const T& value) { return summary_type(value, value); }
+    static summary_type combine(const summary_type& a, const summary_type& b)
+    {
+        return summary_type(std::min(a.first, b.first), std::max(a.second, b.second));
+    }
+};
+
+
+/**@struct CountSummary
+	@brief Number of values, so aggregate(lo, hi) counts the values in a range
+ */
+template <typename T>
+struct CountSummary
+{
+    typedef std::size_t summary_type;
+    static summary_type identity() { return 0; }
+    static summary_type from_value(const T&) { return 1; }
+    static summary_type combine(summary_type a, summary_type b) { return a + b; }
+};
+
+#endif /* TreeSummary_h */
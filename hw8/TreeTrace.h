@@ -0,0 +1,325 @@
+/** @file TreeTrace.h
+ @brief Contains the binary trace format that RecordingSearchTree writes and the replay program reads, with TraceWriter and read_trace.
+
+ A trace starts with a 20 byte header: the magic "BSTTRACE", a code for the value type (see TraceValue), the size of a value in bytes and
+ a code for the ordering of the tree that recorded it (see TraceOrder), so the replay builds its trees with the same comparator.
+ After that every operation is one byte naming it, followed by the raw bytes of its key, except for iterate, which has no key. An int
+ operation takes 5 bytes. Values are stored as raw bytes, so T has to be trivially copyable, and traces use the byte order of the machine
+ that wrote them.
+ */
+
+#ifndef TreeTrace_h
+#define TreeTrace_h
+#include "TreeWriter.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**@enum TraceOp
+	@brief Operations a trace records. find also stands for contains, and iterate for a walk over the whole tree.
+ */
+enum class TraceOp : std::uint8_t { insert = 1, erase = 2, find = 3, iterate = 4 };
+
+
+/**@struct TraceValue
+	@brief Code a trace header stores for its value type, so a replay reads values back as the type they were written as. 0 means a type
+ the replay program does not know, and TraceWriter refuses to record those. The codes of every type replay knows are set here, so they
+ are the same in every file.
+ */
+template <typename T>
+struct TraceValue
+{
+    static const std::uint32_t code = 0;
+};
+
+template <>
+struct TraceValue<int>
+{
+    static const std::uint32_t code = 1;
+};
+
+class Point2D;
+
+template <>
+struct TraceValue<Point2D>
+{
+    static const std::uint32_t code = 2;
+};
+
+
+/**@struct TraceOrder
+	@brief Code a trace header stores for the comparator of the tree that recorded it, chosen like TraceValue. 0 means an ordering the
+ replay program does not know, and TraceWriter refuses to record those.
+ */
+template <typename CMP>
+struct TraceOrder
+{
+    static const std::uint32_t code = 0;
+};
+
+template <typename T>
+struct TraceOrder<std::less<T>>
+{
+    static const std::uint32_t code = 1;
+};
+
+template <typename T>
+struct TraceOrder<std::greater<T>>
+{
+    static const std::uint32_t code = 2;
+};
+
+class PointOrderx;
+
+template <>
+struct TraceOrder<PointOrderx>
+{
+    static const std::uint32_t code = 3;
+};
+
+class PointOrdery;
+
+template <>
+struct TraceOrder<PointOrdery>
+{
+    static const std::uint32_t code = 4;
+};
+
+
+/**@struct TraceHeader
+	@brief The start of a trace file.
+ */
+struct TraceHeader
+{
+    //"BSTTRACE"
+    char magic[8];
+    //TraceValue<T>::code of the values
+    std::uint32_t value_code;
+    //sizeof(T)
+    std::uint32_t value_bytes;
+    //TraceOrder<CMP>::code of the tree's comparator
+    std::uint32_t order_code;
+};
+
+
+/**@struct TraceRecord
+	@brief One operation read back from a trace, key is left default constructed for iterate.
+ */
+template <typename T>
+struct TraceRecord
+{
+    TraceOp op;
+    T key;
+};
+
+
+/**@class TraceWriter
+	@brief Appends operations to a trace file through an OutputBuffer, so recording costs a copy into memory and one write per megabyte.
+ */
+template <typename T,typename CMP>
+class TraceWriter
+{
+    static_assert(std::is_trivially_copyable<T>::value, "traces store values as raw bytes, so T has to be trivially copyable");
+    static_assert(TraceValue<T>::code != 0, "replay can't read traces of this value type, give it a TraceValue code first");
+    static_assert(TraceOrder<CMP>::code != 0, "replay can't rebuild trees with this comparator, give it a TraceOrder code first");
+
+public:
+    //constructor for a writer with no file open
+    TraceWriter();
+    //a writer owns its file, so it can't be copied
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    //destructor, closes the file
+    ~TraceWriter();
+    //create the trace file and write its header
+    void open(const std::string& path);
+    //write out what is buffered and close the file
+    void close();
+    //true if a file is open
+    bool is_open() const;
+    //append an operation and its key
+    void record(TraceOp op, const T& key);
+    //append an operation without a key
+    void record(TraceOp op);
+
+private:
+    //open trace file, -1 if there is none
+    int fd;
+    //buffer in front of fd
+    std::unique_ptr<OutputBuffer> out;
+};
+
+
+/** Definition of the constructor
+ */
+template <typename T,typename CMP>
+TraceWriter<T,CMP>::TraceWriter()
+{
+    fd = -1;
+}
+
+
+/** Definition of the destructor. A destructor must not throw, so errors from writing out the rest of the trace are lost; call close() first
+ to see them.
+ */
+template <typename T,typename CMP>
+TraceWriter<T,CMP>::~TraceWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+
+/** Definition of the open function, that replaces any trace that was open.
+
+ @param path of the trace file, which is created or truncated
+ @throws std::system_error if the file can't be created or written
+ */
+template <typename T,typename CMP>
+void TraceWriter<T,CMP>::open(const std::string& path)
+{
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "TraceWriter: create " + path);
+    out.reset(new OutputBuffer(fd));
+    TraceHeader header;
+    std::memcpy(header.magic, "BSTTRACE", 8);
+    header.value_code = TraceValue<T>::code;
+    header.value_bytes = sizeof(T);
+    header.order_code = TraceOrder<CMP>::code;
+    out->append(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+
+/** Definition of the close function
+
+ @throws std::system_error if the rest of the trace can't be written
+ */
+template <typename T,typename CMP>
+void TraceWriter<T,CMP>::close()
+{
+    if (fd < 0) return;
+    //close the file even if the last write fails
+    int closing = fd;
+    fd = -1;
+    std::unique_ptr<OutputBuffer> buffer(std::move(out));
+    try
+    {
+        buffer->flush();
+    }
+    catch (...)
+    {
+        ::close(closing);
+        throw;
+    }
+    if (::close(closing) != 0) throw std::system_error(errno, std::generic_category(), "TraceWriter: close");
+}
+
+
+/** Definition of the is_open function
+
+ @return true if operations are being recorded to a file
+ */
+template <typename T,typename CMP>
+bool TraceWriter<T,CMP>::is_open() const
+{
+    return fd >= 0;
+}
+
+
+/** Definition of the record function for operations with a key
+
+ @param op is the operation
+ @param key is the value it was called with
+ */
+template <typename T,typename CMP>
+void TraceWriter<T,CMP>::record(TraceOp op, const T& key)
+{
+    char* p = out->reserve(1 + sizeof(T));
+    *p = static_cast<char>(op);
+    std::memcpy(p + 1, static_cast<const void*>(&key), sizeof(T));
+    out->commit(p + 1 + sizeof(T));
+}
+
+
+/** Definition of the record function for operations without a key
+
+ @param op is the operation
+ */
+template <typename T,typename CMP>
+void TraceWriter<T,CMP>::record(TraceOp op)
+{
+    out->put(static_cast<char>(op));
+}
+
+
+/** Reads the header of a trace, so a reader can pick the value type and comparator before reading the operations.
+
+ @param path of the trace file
+ @return its header
+ @throws std::runtime_error if the file can't be read or is not a trace
+ */
+inline TraceHeader read_trace_header(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    TraceHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, "BSTTRACE", 8) != 0)
+        throw std::runtime_error("read_trace: " + path + " is not a trace");
+    return header;
+}
+
+
+/** Reads a whole trace into memory.
+
+ @param path of the trace file
+ @return the operations in the order they were recorded
+ @throws std::runtime_error if the file is not a trace of T values ordered by CMP, or ends in the middle of an operation
+ */
+template <typename T,typename CMP>
+std::vector<TraceRecord<T>> read_trace(const std::string& path)
+{
+    TraceHeader header = read_trace_header(path);
+    if (header.value_code != TraceValue<T>::code || header.value_bytes != sizeof(T))
+        throw std::runtime_error("read_trace: " + path + " holds a different value type");
+    if (header.order_code != TraceOrder<CMP>::code)
+        throw std::runtime_error("read_trace: " + path + " was recorded with a different ordering");
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<TraceRecord<T>> records;
+    std::size_t pos = sizeof(TraceHeader);
+    while (pos < bytes.size())
+    {
+        TraceRecord<T> record = TraceRecord<T>();
+        record.op = static_cast<TraceOp>(bytes[pos++]);
+        if (record.op == TraceOp::insert || record.op == TraceOp::erase || record.op == TraceOp::find)
+        {
+            if (bytes.size() - pos < sizeof(T))
+                throw std::runtime_error("read_trace: " + path + " ends in the middle of an operation");
+            std::memcpy(static_cast<void*>(&record.key), bytes.data() + pos, sizeof(T));
+            pos += sizeof(T);
+        }
+        else if (record.op != TraceOp::iterate)
+            throw std::runtime_error("read_trace: " + path + " holds an unknown operation");
+        records.push_back(record);
+    }
+    return records;
+}
+
+#endif /* TreeTrace_h */
@@ -0,0 +1,343 @@
+/** @file TreeWriter.h
+ @brief Contains the OutputFormat options, the OutputBuffer class and the ValueWriter trait that BinarySearchTree::write_to uses to dump a tree.
+
+ Writing a big tree one value at a time with operator<< spends most of its time in stream machinery (sentries, locale lookups, a virtual call
+ per value). Instead, values are formatted straight into one large OutputBuffer, integers with std::to_chars, and the buffer is handed to the
+ stream or file descriptor in a few big writes.
+
+ ValueWriter<T> decides how a value looks in each format. Integers, std::string and Point2D have their own versions, all in this file so
+ every tree of them is written the same way whatever else a file includes. Any other
+ type falls back to operator<< for text and CSV, and to its raw bytes in binary if it is trivially copyable (its text, prefixed with a
+ 32 bit length, if not). Binary output uses the byte order of the machine.
+ */
+
+#ifndef TreeWriter_h
+#define TreeWriter_h
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+
+/**@enum OutputFormat
+	@brief How write_to lays out values: one per line as print() does, as CSV rows, or as packed binary records.
+ */
+enum class OutputFormat { text, csv, binary };
+
+
+/**@class OutputBuffer
+	@brief A large output buffer in front of a std::ostream or a file descriptor. Formatters reserve room, write into it directly, and commit
+ what they wrote. The buffer is handed on only when it is full or flushed.
+ */
+class OutputBuffer
+{
+public:
+    //buffer in front of a stream
+    explicit OutputBuffer(std::ostream& os, std::size_t capacity = 1 << 20);
+    //buffer in front of a file descriptor
+    explicit OutputBuffer(int file, std::size_t capacity = 1 << 20);
+    //get room for at least n bytes, flushing first if there is not enough
+    char* reserve(std::size_t n);
+    //mark the bytes up to end as written
+    void commit(char* end);
+    //copy bytes into the buffer
+    void append(const char* data, std::size_t n);
+    //copy one character into the buffer
+    void put(char c);
+    //hand everything buffered to the stream or file descriptor
+    void flush();
+
+private:
+    //write bytes to the stream or file descriptor
+    void write_out(const char* data, std::size_t n);
+    //the buffered bytes, left uninitialised since only the first used bytes are ever read
+    std::unique_ptr<char[]> buffer;
+    //size of buffer in bytes
+    std::size_t bufferSize;
+    //number of bytes in use
+    std::size_t used;
+    //stream to write to, nullptr when writing to fd
+    std::ostream* stream;
+    //file descriptor to write to
+    int fd;
+};
+
+
+/** Definition of the stream constructor
+
+ @param os is the stream the buffer is written to
+ @param capacity is the size of the buffer in bytes
+ */
+inline OutputBuffer::OutputBuffer(std::ostream& os, std::size_t capacity) : bufferSize(capacity > 64 ? capacity : 64)
+{
+    buffer.reset(new char[bufferSize]);
+    used = 0;
+    stream = &os;
+    fd = -1;
+}
+
+
+/** Definition of the file descriptor constructor
+
+ @param file is the open file descriptor the buffer is written to
+ @param capacity is the size of the buffer in bytes
+ */
+inline OutputBuffer::OutputBuffer(int file, std::size_t capacity) : bufferSize(capacity > 64 ? capacity : 64)
+{
+    buffer.reset(new char[bufferSize]);
+    used = 0;
+    stream = nullptr;
+    fd = file;
+}
+
+
+/** Definition of the reserve function. Requests bigger than the whole buffer grow it.
+
+ @param n is the number of bytes the caller is about to write
+ @return where to write them
+ */
+inline char* OutputBuffer::reserve(std::size_t n)
+{
+    if (bufferSize - used < n)
+    {
+        flush();
+        //nothing is buffered after the flush, so there is nothing to copy over
+        if (bufferSize < n)
+        {
+            buffer.reset(new char[n]);
+            bufferSize = n;
+        }
+    }
+    return buffer.get() + used;
+}
+
+
+/** Definition of the commit function
+
+ @param end is one after the last byte written since reserve
+ */
+inline void OutputBuffer::commit(char* end)
+{
+    used = end - buffer.get();
+}
+
+
+/** Definition of the append function. Blocks bigger than the buffer skip it and are written out directly.
+
+ @param data is the bytes to write
+ @param n is the number of bytes
+ */
+inline void OutputBuffer::append(const char* data, std::size_t n)
+{
+    if (n > bufferSize)
+    {
+        flush();
+        write_out(data, n);
+        return;
+    }
+    char* out = reserve(n);
+    std::memcpy(out, data, n);
+    used += n;
+}
+
+
+/** Definition of the put function
+
+ @param c is the character to write
+ */
+inline void OutputBuffer::put(char c)
+{
+    *reserve(1) = c;
+    ++used;
+}
+
+
+/** Definition of the flush function
+ */
+inline void OutputBuffer::flush()
+{
+    write_out(buffer.get(), used);
+    used = 0;
+}
+
+
+/** Definition of the write_out function. A stream reports errors through its state as usual. write() to a file descriptor may write less
+ than asked or be interrupted, so it is repeated until everything is written, and any other failure throws.
+
+ @param data is the bytes to write
+ @param n is the number of bytes
+ @throws std::system_error if writing to the file descriptor fails
+ */
+inline void OutputBuffer::write_out(const char* data, std::size_t n)
+{
+    if (stream != nullptr)
+    {
+        stream->write(data, static_cast<std::streamsize>(n));
+        return;
+    }
+    while (n > 0)
+    {
+        ssize_t written = ::write(fd, data, n);
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "write_to");
+        }
+        data += written;
+        n -= static_cast<std::size_t>(written);
+    }
+}
+
+
+/** Writes one CSV field, quoting it if it holds a comma, a quote or a line break, and doubling any quotes inside it.
+
+ @param out is the buffer to write to
+ @param data is the text of the field
+ @param n is its length
+ */
+inline void write_csv_field(OutputBuffer& out, const char* data, std::size_t n)
+{
+    bool quote = false;
+    for (std::size_t i = 0; i < n && !quote; ++i)
+        quote = data[i] == ',' || data[i] == '"' || data[i] == '\n' || data[i] == '\r';
+    if (!quote)
+    {
+        out.append(data, n);
+        return;
+    }
+    out.put('"');
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (data[i] == '"') out.put('"');
+        out.put(data[i]);
+    }
+    out.put('"');
+}
+
+
+/**@struct ValueWriter
+	@brief Writes a value of type T in one of the OutputFormats. This general version goes through operator<<; faster versions for particular
+ types are below and next to those types.
+ */
+template <typename T,typename Enable=void>
+struct ValueWriter
+{
+    static void write(OutputBuffer& out, const T& value, OutputFormat format)
+    {
+        if (format == OutputFormat::binary)
+        {
+            if constexpr (std::is_trivially_copyable<T>::value)
+            {
+                out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+                return;
+            }
+        }
+        std::ostringstream text;
+        text << value;
+        const std::string& s = text.str();
+        if (format == OutputFormat::text)
+        {
+            out.append(s.data(), s.size());
+            out.put('\n');
+        }
+        else if (format == OutputFormat::csv)
+        {
+            write_csv_field(out, s.data(), s.size());
+            out.put('\n');
+        }
+        else
+        {
+            std::uint32_t length = static_cast<std::uint32_t>(s.size());
+            out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.append(s.data(), s.size());
+        }
+    }
+};
+
+
+/**@struct ValueWriter for integers
+	@brief Formats integers with std::to_chars, and writes them in binary as their raw bytes. bool and the character types keep the general
+ version, since operator<< prints those differently.
+ */
+template <typename T>
+struct ValueWriter<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T,bool>::value && !std::is_same<T,char>::value &&
+                                              !std::is_same<T,signed char>::value && !std::is_same<T,unsigned char>::value>::type>
+{
+    static void write(OutputBuffer& out, T value, OutputFormat format)
+    {
+        if (format == OutputFormat::binary)
+        {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+            return;
+        }
+        //text and CSV rows look the same for a single number
+        char* p = out.reserve(24);
+        p = std::to_chars(p, p + 23, value).ptr;
+        *p++ = '\n';
+        out.commit(p);
+    }
+};
+
+
+/**@struct ValueWriter for std::string
+	@brief Writes strings as they are in text, quoted when needed in CSV, and prefixed with a 32 bit length in binary.
+ */
+template <>
+struct ValueWriter<std::string>
+{
+    static void write(OutputBuffer& out, const std::string& value, OutputFormat format)
+    {
+        if (format == OutputFormat::binary)
+        {
+            std::uint32_t length = static_cast<std::uint32_t>(value.size());
+            out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.append(value.data(), value.size());
+            return;
+        }
+        if (format == OutputFormat::csv)
+            write_csv_field(out, value.data(), value.size());
+        else
+            out.append(value.data(), value.size());
+        out.put('\n');
+    }
+};
+
+
+//Point2D is only declared here, so writing a tree does not depend on the point class
+class Point2D;
+
+/**@struct ValueWriter for Point2D
+	@brief Writes a Point2D: "(x y)" in text like operator<<, "x,y" in CSV, and x then y as 32 bit integers in binary. write is a template
+ so its body, which needs the whole class, is only compiled where a point is written, by which time Point2D.h has been included.
+ */
+template <>
+struct ValueWriter<Point2D>
+{
+    template <typename P>
+    static void write(OutputBuffer& out, const P& value, OutputFormat format)
+    {
+        if (format == OutputFormat::binary)
+        {
+            std::int32_t xy[2] = {value.getx(), value.gety()};
+            out.append(reinterpret_cast<const char*>(xy), sizeof(xy));
+            return;
+        }
+        char* p = out.reserve(32);
+        if (format == OutputFormat::text) *p++ = '(';
+        p = std::to_chars(p, p + 11, value.getx()).ptr;
+        *p++ = format == OutputFormat::text ? ' ' : ',';
+        p = std::to_chars(p, p + 11, value.gety()).ptr;
+        if (format == OutputFormat::text) *p++ = ')';
+        *p++ = '\n';
+        out.commit(p);
+    }
+};
+
+#endif /* TreeWriter_h */
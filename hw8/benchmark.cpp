@@ -0,0 +1,714 @@
+/** @file benchmark.cpp
+ @brief Times the binary search tree and its variants on different workloads.
+
+ This is its own program, separate from main.cpp. It is built with something like
+    clang++ -std=c++17 -O2 -pthread benchmark.cpp -o benchmark
+ and run as "benchmark [group] [n]", where group picks one set of benchmarks (all of them if left out) and n is the number of keys.
+ Each line of output is the name of a benchmark, the number of operations, and the nanoseconds per operation.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include "BinarySearchTree.h"
+#include "BufferedSearchTree.h"
+#include "RadixTree.h"
+#include "StaticSearchTree.h"
+#include "PagedSearchTree.h"
+#include "TreeSummary.h"
+
+
+/** Runs a piece of work once and prints how long each of its operations took on average.
+
+ @param name of the benchmark
+ @param ops is the number of operations the work performs
+ @param work is the function to time
+ */
+template <typename F>
+void time_it(const std::string& name, std::size_t ops, F work)
+{
+    auto start = std::chrono::steady_clock::now();
+    work();
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::cout << name << " " << ops << " " << (ops ? ns / ops : 0.0) << " ns/op" << std::endl;
+}
+
+
+/** Makes a stream of n keys in one of the shapes we get in production: ascending, descending, or ascending with a few keys swapped out of place.
+
+ @param n is the number of keys
+ @param shape is "ascending", "descending" or "nearly-sorted"
+ @return the keys in insertion order
+ */
+std::vector<int> make_stream(std::size_t n, const std::string& shape)
+{
+    std::vector<int> keys(n);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(i);
+    if (shape == "descending")
+        std::reverse(keys.begin(), keys.end());
+    else if (shape == "nearly-sorted")
+    {
+        //swap 1% of the keys with a neighbour a short distance away
+        std::mt19937 rng(42);
+        for (std::size_t i = 0; i < n / 100; ++i)
+        {
+            std::size_t a = rng() % n;
+            std::size_t b = std::min(n - 1, a + rng() % 16);
+            std::swap(keys[a], keys[b]);
+        }
+    }
+    return keys;
+}
+
+
+/** Compares plain insert against inserting with the previous result as the hint, for ascending, descending and nearly sorted streams.
+ Without balancing, a plain insert of a descending stream walks the whole left spine each time, so keep n moderate. Last, at least a
+ million ascending keys are inserted, copied and destroyed, which must not overflow the stack.
+
+ @param n is the number of keys
+ */
+void bench_monotone_inserts(std::size_t n)
+{
+    const char* shapes[] = {"ascending", "descending", "nearly-sorted"};
+    for (const char* shape : shapes)
+    {
+        std::vector<int> keys = make_stream(n, shape);
+
+        time_it(std::string("insert/") + shape, n, [&] {
+            BinarySearchTree<int> bst;
+            for (int k : keys)
+                bst.insert(k);
+        });
+
+        time_it(std::string("hinted-insert/") + shape, n, [&] {
+            BinarySearchTree<int> bst;
+            TreeIterator<int,std::less<int>> hint = bst.end();
+            for (int k : keys)
+                hint = bst.insert(hint, k);
+        });
+    }
+
+    //ascending inserts append in O(1) and leave one long right spine, which copying and destroying must handle without recursing
+    std::size_t large = std::max<std::size_t>(n, 1000000);
+    std::vector<int> spine = make_stream(large, "ascending");
+    time_it("insert-copy-destroy/ascending-" + std::to_string(large), large, [&] {
+        BinarySearchTree<int> bst;
+        for (int k : spine)
+            bst.insert(k);
+        BinarySearchTree<int> copy(bst);
+    });
+}
+
+
+/** Times priority-queue style processing: look at the smallest key with begin(), then remove it with pop_min(), until the tree is empty.
+
+ @param n is the number of keys
+ */
+void bench_pop_min(std::size_t n)
+{
+    std::vector<int> keys(n);
+    std::mt19937 rng(7);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(rng());
+
+    BinarySearchTree<int> bst;
+    for (int k : keys)
+        bst.insert(k);
+
+    time_it("pop_min", n, [&] {
+        while (bst.begin() != bst.end())
+            bst.pop_min();
+    });
+}
+
+
+/** Times expiring half of the keys at once, first with plain erase and then with lazy erase followed by one compact(), and then refilling the
+ tree, which reuses the nodes compaction freed.
+
+ @param n is the number of keys
+ */
+void bench_lazy_erase(std::size_t n)
+{
+    std::vector<int> keys(n);
+    std::mt19937 rng(11);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(rng());
+    std::vector<int> expired(keys.begin(), keys.begin() + n / 2);
+
+    BinarySearchTree<int> eager;
+    for (int k : keys)
+        eager.insert(k);
+    time_it("erase/eager", expired.size(), [&] {
+        for (int k : expired)
+            eager.erase(k);
+    });
+
+    BinarySearchTree<int> lazy;
+    //a ratio above 1 never compacts on its own, so compaction is timed separately
+    lazy.set_lazy_erase(true, 2.0);
+    for (int k : keys)
+        lazy.insert(k);
+    time_it("erase/lazy", expired.size(), [&] {
+        for (int k : expired)
+            lazy.erase(k);
+    });
+    time_it("compact", lazy.size() + lazy.stats().tombstones, [&] {
+        lazy.compact();
+    });
+    time_it("insert/recycled", expired.size(), [&] {
+        for (int k : expired)
+            lazy.insert(k);
+    });
+    std::cout << "recycled nodes " << lazy.stats().recycled_nodes << ", compactions " << lazy.stats().compactions << std::endl;
+}
+
+
+/** Compares inserting random keys one at a time against the write buffered tree with a few buffer sizes. The goal is several times the
+ throughput of plain insert at 10M keys and more.
+
+ @param n is the number of keys
+ */
+void bench_buffered_inserts(std::size_t n)
+{
+    std::vector<int> keys(n);
+    std::mt19937 rng(13);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(rng());
+
+    time_it("insert/per-key", n, [&] {
+        BinarySearchTree<int> bst;
+        for (int k : keys)
+            bst.insert(k);
+    });
+
+    const std::size_t thresholds[] = {1024, 16384, 262144};
+    for (std::size_t threshold : thresholds)
+    {
+        BufferedSearchTree<int> buffered(threshold);
+        time_it("insert/buffered-" + std::to_string(threshold), n, [&] {
+            for (int k : keys)
+                buffered.insert(k);
+            buffered.flush();
+        });
+        std::cout << "write amplification " << buffered.write_amplification() << ", flushes " << buffered.stats().flushes << std::endl;
+    }
+}
+
+
+/** Compares the radix tree against BinarySearchTree<std::string> on URL-like keys that share long prefixes. It reports bytes per key and
+ the time of looking up every key in random order, and of looking up keys that are not there. The tree's memory is counted as its nodes plus
+ the heap buffer of each string too long for the small string buffer.
+
+ @param n is the number of keys
+ */
+void bench_radix(std::size_t n)
+{
+    std::mt19937 rng(17);
+    const char* hosts[] = {"https://www.example.com/", "https://api.example.com/v2/", "https://cdn.example.org/static/"};
+    const char* paths[] = {"users/", "orders/", "products/", "search?q="};
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        keys.push_back(std::string(hosts[rng() % 3]) + paths[rng() % 4] + std::to_string(rng() % (10 * n)) + "/profile");
+    std::vector<std::string> misses;
+    for (std::size_t i = 0; i < n; ++i)
+        misses.push_back(keys[i] + "/edit");
+
+    BinarySearchTree<std::string> bst;
+    RadixTree<> radix;
+    for (const std::string& k : keys)
+    {
+        bst.insert(k);
+        radix.insert(k);
+    }
+
+    std::size_t bst_bytes = 0;
+    for (const std::string& k : bst)
+    {
+        bst_bytes += sizeof(TreeNode<std::string,std::less<std::string>>);
+        if (k.capacity() >= sizeof(std::string))
+            bst_bytes += k.capacity() + 1;
+    }
+    std::cout << "bytes/key bst " << static_cast<double>(bst_bytes) / bst.size()
+              << ", radix " << static_cast<double>(radix.memory_usage()) / radix.size() << std::endl;
+
+    std::shuffle(keys.begin(), keys.end(), rng);
+    std::size_t found = 0;
+    time_it("lookup/bst", n, [&] {
+        for (const std::string& k : keys)
+            found += bst.find(k) != bst.end();
+    });
+    time_it("lookup/radix", n, [&] {
+        for (const std::string& k : keys)
+            found += radix.contains(k);
+    });
+    time_it("miss/bst", n, [&] {
+        for (const std::string& k : misses)
+            found += bst.find(k) != bst.end();
+    });
+    time_it("miss/radix", n, [&] {
+        for (const std::string& k : misses)
+            found += radix.contains(k);
+    });
+    std::cout << "found " << found << std::endl;
+}
+
+
+/** Compares a loop of single find and lower_bound calls against find_many and lower_bound_many, on batches of 256 random keys of which about
+ half are in the tree. The interleaving only pays off once the tree does not fit in the last level cache, so run it with n in the millions.
+
+ @param n is the number of keys
+ */
+void bench_batched_lookups(std::size_t n)
+{
+    std::mt19937 rng(19);
+    BinarySearchTree<int> bst;
+    for (std::size_t i = 0; i < n; ++i)
+        bst.insert(static_cast<int>(rng() % (2 * n)));
+    std::vector<int> queries(n);
+    for (std::size_t i = 0; i < n; ++i)
+        queries[i] = static_cast<int>(rng() % (2 * n));
+
+    const std::size_t batch = 256;
+    std::vector<int> keys;
+    std::vector<TreeIterator<int,std::less<int>>> results;
+    std::size_t found = 0;
+
+    time_it("find/single", n, [&] {
+        for (int k : queries)
+            found += bst.find(k) != bst.end();
+    });
+    time_it("find/batched", n, [&] {
+        for (std::size_t i = 0; i < n; i += batch)
+        {
+            keys.assign(queries.begin() + i, queries.begin() + std::min(n, i + batch));
+            bst.find_many(keys, results);
+            for (const TreeIterator<int,std::less<int>>& it : results)
+                found += it != bst.end();
+        }
+    });
+    time_it("lower_bound/single", n, [&] {
+        for (int k : queries)
+            found += bst.lower_bound(k) != bst.end();
+    });
+    time_it("lower_bound/batched", n, [&] {
+        for (std::size_t i = 0; i < n; i += batch)
+        {
+            keys.assign(queries.begin() + i, queries.begin() + std::min(n, i + batch));
+            bst.lower_bound_many(keys, results);
+            for (const TreeIterator<int,std::less<int>>& it : results)
+                found += it != bst.end();
+        }
+    });
+    std::cout << "found " << found << std::endl;
+}
+
+
+/** Compares summing every key by stepping an iterator against parallel_reduce, and collecting every key against parallel_transform, with
+ 1, 2, 4, ... threads up to the number of cores. The tree is built with merge_sorted, so it is balanced and splits evenly.
+
+ @param n is the number of keys
+ */
+void bench_parallel_scan(std::size_t n)
+{
+    std::vector<int> keys(n);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(i);
+    BinarySearchTree<int> bst;
+    bst.merge_sorted(keys.begin(), keys.end());
+
+    long long sum = 0;
+    time_it("scan/iterator", n, [&] {
+        for (int k : bst)
+            sum += k;
+    });
+    std::size_t collected = 0;
+    time_it("collect/iterator", n, [&] {
+        std::vector<int> out;
+        out.reserve(n);
+        for (int k : bst)
+            out.push_back(k);
+        collected += out.size();
+    });
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned step = 1; ; step *= 2)
+    {
+        unsigned threads = std::min(step, cores);
+        bst.set_parallel_threads(threads);
+        time_it("scan/parallel-" + std::to_string(threads), n, [&] {
+            sum += bst.parallel_reduce(0LL, [](long long a, long long b) { return a + b; });
+        });
+        time_it("collect/parallel-" + std::to_string(threads), n, [&] {
+            collected += bst.parallel_transform([](int& k) { return k; }).size();
+        });
+        if (threads == cores) break;
+    }
+    std::cout << "sum " << sum << ", collected " << collected << std::endl;
+}
+
+
+/** Times finds whose keys follow a Zipf distribution (the k-th most popular key is looked up in proportion to 1/k), with the popular keys
+ scattered over the key range. Compares the tree as random inserts left it, the same tree with splaying on every find and on every 8th find,
+ and a tree balanced with compact().
+
+ @param n is the number of keys
+ */
+void bench_zipf_finds(std::size_t n)
+{
+    std::mt19937 rng(23);
+    std::vector<int> keys(n);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(rng());
+
+    //popularity ranks are handed out in random order, so hot keys are not clustered
+    std::vector<double> cdf(n);
+    double total = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        cdf[i] = total += 1.0 / (i + 1);
+    std::vector<int> by_rank(keys);
+    std::shuffle(by_rank.begin(), by_rank.end(), rng);
+    std::uniform_real_distribution<double> uniform(0, total);
+    std::vector<int> queries(10 * n);
+    for (int& q : queries)
+        q = by_rank[std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin()];
+
+    struct Variant { const char* name; std::size_t splay_interval; bool balanced; };
+    const Variant variants[] = {{"plain", 0, false}, {"splay-1", 1, false}, {"splay-8", 8, false}, {"balanced", 0, true}};
+    for (const Variant& variant : variants)
+    {
+        BinarySearchTree<int> bst;
+        for (int k : keys)
+            bst.insert(k);
+        if (variant.balanced)
+            bst.compact();
+        bst.set_splay_interval(variant.splay_interval);
+        std::size_t found = 0;
+        time_it(std::string("zipf-find/") + variant.name, queries.size(), [&] {
+            for (int q : queries)
+                found += bst.find(q) != bst.end();
+        });
+        std::cout << "found " << found << ", rotations " << bst.stats().rotations << std::endl;
+    }
+}
+
+
+/** Times find on a workload where 90% of the lookups are for missing keys, without a filter and with filters at a few false positive rates.
+
+ @param n is the number of keys
+ */
+void bench_filtered_finds(std::size_t n)
+{
+    std::mt19937 rng(29);
+    std::vector<int> keys(n);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(rng() & ~1u);
+    std::vector<int> queries(n);
+    for (std::size_t i = 0; i < n; ++i)
+        queries[i] = i % 10 == 0 ? keys[rng() % n] : static_cast<int>(rng() | 1u);
+
+    const double rates[] = {0.0, 0.05, 0.01, 0.001};
+    for (double rate : rates)
+    {
+        BinarySearchTree<int> bst;
+        for (int k : keys)
+            bst.insert(k);
+        if (rate > 0)
+            bst.set_filter(true, rate);
+        std::size_t found = 0;
+        time_it(rate > 0 ? "find/filter-" + std::to_string(rate) : std::string("find/no-filter"), n, [&] {
+            for (int q : queries)
+                found += bst.find(q) != bst.end();
+        });
+        std::cout << "found " << found << ", skipped " << bst.stats().filter_negatives
+                  << ", false positives " << bst.stats().filter_false_positives << std::endl;
+    }
+}
+
+
+/** Compares dumping every key the way print() used to (operator<< and "\n" for each value) against write_to in each format, to a stream and
+ to a file descriptor. Everything is written to /dev/null, so only formatting and the write calls are timed.
+
+ @param n is the number of keys
+ */
+void bench_output(std::size_t n)
+{
+    std::vector<int> keys(n);
+    std::mt19937 rng(31);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(rng());
+    std::sort(keys.begin(), keys.end());
+    BinarySearchTree<int> bst;
+    bst.merge_sorted(keys.begin(), keys.end());
+
+    std::ofstream null_stream("/dev/null");
+    time_it("output/operator<<", bst.size(), [&] {
+        for (int k : bst)
+            null_stream << k << "\n";
+        null_stream.flush();
+    });
+    time_it("output/stream-text", bst.size(), [&] {
+        bst.write_to(null_stream);
+    });
+    int fd = ::open("/dev/null", O_WRONLY);
+    time_it("output/fd-text", bst.size(), [&] {
+        bst.write_to(fd);
+    });
+    time_it("output/fd-csv", bst.size(), [&] {
+        bst.write_to(fd, OutputFormat::csv);
+    });
+    time_it("output/fd-binary", bst.size(), [&] {
+        bst.write_to(fd, OutputFormat::binary);
+    });
+    ::close(fd);
+}
+
+
+/** Compares summing random ranges by walking them with iterators against aggregate on a tree that keeps subtree sums. Both trees are
+ built with merge_sorted so they are balanced.
+
+ @param n is the number of keys
+ */
+void bench_range_aggregate(std::size_t n)
+{
+    std::vector<int> keys(n);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(i);
+    BinarySearchTree<int> plain;
+    plain.merge_sorted(keys.begin(), keys.end());
+    BinarySearchTree<int,std::less<int>,SumSummary<int,long long>> summed;
+    summed.merge_sorted(keys.begin(), keys.end());
+
+    const std::size_t queries = 1000;
+    std::vector<std::pair<int,int>> ranges(queries);
+    std::mt19937 rng(37);
+    for (std::pair<int,int>& r : ranges)
+    {
+        int a = static_cast<int>(rng() % n);
+        int b = static_cast<int>(rng() % n);
+        r = std::make_pair(std::min(a, b), std::max(a, b));
+    }
+
+    long long walked = 0;
+    time_it("aggregate/iterate", queries, [&] {
+        for (const std::pair<int,int>& r : ranges)
+        {
+            for (TreeIterator<int,std::less<int>> it = plain.lower_bound(r.first); it != plain.end() && *it < r.second; ++it)
+                walked += *it;
+        }
+    });
+    long long aggregated = 0;
+    time_it("aggregate/summary", queries, [&] {
+        for (const std::pair<int,int>& r : ranges)
+            aggregated += summed.aggregate(r.first, r.second);
+    });
+    std::cout << "sums match " << (walked == aggregated ? "yes" : "no") << std::endl;
+}
+
+
+/** Compares keeping the k largest values of a random stream with insert, smallest and erase against offer on a tree bounded with set_capacity.
+
+ @param n is the number of values in the stream
+ */
+void bench_top_k(std::size_t n)
+{
+    std::vector<int> stream(n);
+    std::mt19937 rng(41);
+    for (std::size_t i = 0; i < n; ++i)
+        stream[i] = static_cast<int>(rng());
+
+    const std::size_t capacities[] = {100, 10000};
+    for (std::size_t k : capacities)
+    {
+        time_it("topk/insert-erase-" + std::to_string(k), n, [&] {
+            BinarySearchTree<int> bst;
+            for (int v : stream)
+            {
+                bst.insert(v);
+                if (bst.size() > k)
+                    bst.erase(bst.smallest());
+            }
+        });
+        BinarySearchTree<int> bounded;
+        bounded.set_capacity(k);
+        time_it("topk/offer-" + std::to_string(k), n, [&] {
+            for (int v : stream)
+                bounded.offer(v);
+        });
+        std::cout << "rejected " << bounded.stats().rejected_offers << ", in place " << bounded.stats().in_place_offers
+                  << ", recycled " << bounded.stats().recycled_nodes << std::endl;
+    }
+}
+
+
+/** Builds the 256 entry table used by bench_static_lookups, scattered over [0, 65536) so it has to be sorted.
+
+ @return the table, sorted by the compiler when used in a constant expression
+ */
+constexpr StaticSearchTree<int,std::less<int>,256> make_lookup_table()
+{
+    int codes[256] = {};
+    for (int i = 0; i < 256; ++i)
+        codes[i] = (i * 7919) % 65536;
+    return StaticSearchTree<int,std::less<int>,256>(codes);
+}
+
+
+/** Compares looking up random keys in a fixed 256 entry table held by a StaticSearchTree built at compile time against the same table
+ inserted into a BinarySearchTree at run time.
+
+ @param n is the number of lookups
+ */
+void bench_static_lookups(std::size_t n)
+{
+    static constexpr StaticSearchTree<int,std::less<int>,256> table = make_lookup_table();
+    BinarySearchTree<int> bst;
+    time_it("static/build-bst", table.size(), [&] {
+        for (int i = 0; i < 256; ++i)
+            bst.insert((i * 7919) % 65536);
+    });
+
+    std::vector<int> keys(n);
+    std::mt19937 rng(43);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(rng() % 65536);
+
+    std::size_t found = 0;
+    time_it("static/find-bst", n, [&] {
+        for (int k : keys)
+            found += bst.find(k) != bst.end();
+    });
+    time_it("static/find-static", n, [&] {
+        for (int k : keys)
+            found += table.find(k) != table.end();
+    });
+    std::cout << "found " << found << std::endl;
+}
+
+
+/** Times the file backed B+ tree with a cache that holds the whole tree and with one that holds a small part of it: random inserts and a
+ flush, random lookups, and a full scan along the leaves. The file goes in /tmp and is removed afterwards.
+
+ @param n is the number of keys
+ */
+void bench_paged(std::size_t n)
+{
+    std::vector<int> keys(n);
+    std::mt19937 rng(47);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(rng());
+
+    const std::size_t budgets[] = {std::size_t(256) << 20, std::size_t(1) << 20};
+    for (std::size_t budget : budgets)
+    {
+        std::string label = std::to_string(budget >> 20) + "MiB";
+        std::string path = "/tmp/bench_paged.db";
+        ::unlink(path.c_str());
+        {
+            PagedSearchTree<int> paged(path, budget);
+            time_it("paged/insert-" + label, n, [&] {
+                for (int k : keys)
+                    paged.insert(k);
+                paged.flush();
+            });
+            std::size_t found = 0;
+            time_it("paged/find-" + label, n, [&] {
+                for (std::size_t i = 0; i < n; ++i)
+                    found += paged.contains(keys[(i * 7919) % n]);
+            });
+            long long sum = 0;
+            time_it("paged/scan-" + label, paged.size(), [&] {
+                for (int k : paged)
+                    sum += k;
+            });
+            std::cout << "found " << found << ", page reads " << paged.stats().page_reads << ", evictions " << paged.stats().evictions
+                      << ", journaled " << paged.stats().journal_writes << std::endl;
+        }
+        ::unlink(path.c_str());
+    }
+}
+
+
+/** Times find with and without the hash index on random keys, half of the lookups hitting and half missing, and times what keeping the
+ index up to date adds to insert.
+
+ @param n is the number of keys
+ */
+void bench_hash_index(std::size_t n)
+{
+    std::mt19937 rng(43);
+    std::vector<int> keys(n);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = static_cast<int>(rng() & ~1u);
+    std::vector<int> queries(n);
+    for (std::size_t i = 0; i < n; ++i)
+        queries[i] = i % 2 == 0 ? keys[rng() % n] : static_cast<int>(rng() | 1u);
+
+    for (bool indexed : {false, true})
+    {
+        std::string label = indexed ? "index" : "no-index";
+        BinarySearchTree<int> bst;
+        bst.set_hash_index(indexed);
+        time_it("index-insert/" + label, n, [&] {
+            for (int k : keys)
+                bst.insert(k);
+        });
+        std::size_t found = 0;
+        time_it("index-find/" + label, n, [&] {
+            for (int q : queries)
+                found += bst.find(q) != bst.end();
+        });
+        std::cout << "found " << found << ", index lookups " << bst.stats().index_lookups << std::endl;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::string group = argc > 1 ? argv[1] : "all";
+    std::size_t n = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+
+    if (group == "all" || group == "monotone")
+        bench_monotone_inserts(n);
+    if (group == "all" || group == "pop")
+        bench_pop_min(n);
+    if (group == "all" || group == "lazy")
+        bench_lazy_erase(n);
+    if (group == "all" || group == "buffered")
+        bench_buffered_inserts(n);
+    if (group == "all" || group == "radix")
+        bench_radix(n);
+    if (group == "all" || group == "batch")
+        bench_batched_lookups(n);
+    if (group == "all" || group == "parallel")
+        bench_parallel_scan(n);
+    if (group == "all" || group == "zipf")
+        bench_zipf_finds(n);
+    if (group == "all" || group == "filter")
+        bench_filtered_finds(n);
+    if (group == "all" || group == "output")
+        bench_output(n);
+    if (group == "all" || group == "aggregate")
+        bench_range_aggregate(n);
+    if (group == "all" || group == "topk")
+        bench_top_k(n);
+    if (group == "all" || group == "static")
+        bench_static_lookups(n);
+    if (group == "all" || group == "paged")
+        bench_paged(n);
+    if (group == "all" || group == "index")
+        bench_hash_index(n);
+
+    return 0;
+}
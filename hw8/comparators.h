@@ -4,12 +4,14 @@
  @date Febuary 11th, 2016
 
 	PointOrderx is a class that orders the Point2D objects based on x component, while PointOrdery orders based on y component
+ Since each one treats points with the same x (or y) as equal, TreeHash is specialised for them to hash only that component.
  */
 
 #ifndef comparators_h
 #define comparators_h
 #include "iostream"
 #include "Point2D.h"
+#include "TreeHash.h"
 
 
 /**@class PointOrderx
@@ -20,7 +22,7 @@ class PointOrderx
 {
 public:
     //overload comparison operator()
-    bool operator()(Point2D& a, Point2D& b);
+    bool operator()(const Point2D& a, const Point2D& b) const;
 };
 
 /**overloading the operator () so that we can compare two objects of type Point2D based on x component
@@ -28,7 +30,7 @@ public:
  @param a is the first Point2D you want to compare
  @param b is the second Point2D you want to compare
  */
-bool PointOrderx:: operator()(Point2D &a, Point2D &b)
+bool PointOrderx:: operator()(const Point2D &a, const Point2D &b) const
 {
     //return true if a.x is less than b.x
     return (a.getx()<b.getx());
@@ -42,7 +44,7 @@ bool PointOrderx:: operator()(Point2D &a, Point2D &b)
 class PointOrdery
 {
 public:
-    bool operator()(Point2D& a, Point2D& b);
+    bool operator()(const Point2D& a, const Point2D& b) const;
 };
 
 /**overloading the operator () so that we can compare two objects of type Point2D based on y component
@@ -50,11 +52,50 @@ public:
  @param a is the first Point2D you want to compare
  @param b is the second Point2D you want to compare
  */
-bool PointOrdery:: operator()(Point2D &a, Point2D &b)
+bool PointOrdery:: operator()(const Point2D &a, const Point2D &b) const
 
 {
     //return true if a.y is less than b.y
     return (a.gety()<b.gety());
 }
 
+/**@struct TreeHash<Point2D,PointOrderx>
+	@brief Hashes a Point2D by its x component only, so points that PointOrderx treats as equal get the same hash
+ */
+template <>
+struct TreeHash<Point2D,PointOrderx>
+{
+    std::size_t operator()(const Point2D& a) const;
+};
+
+/** hashing a Point2D for a tree ordered by PointOrderx
+ 
+ @param a is the Point2D you want to hash
+ @return hash of the x component
+ */
+inline std::size_t TreeHash<Point2D,PointOrderx>::operator()(const Point2D& a) const
+{
+    return std::hash<int>()(a.getx());
+}
+
+
+/**@struct TreeHash<Point2D,PointOrdery>
+	@brief Hashes a Point2D by its y component only, so points that PointOrdery treats as equal get the same hash
+ */
+template <>
+struct TreeHash<Point2D,PointOrdery>
+{
+    std::size_t operator()(const Point2D& a) const;
+};
+
+/** hashing a Point2D for a tree ordered by PointOrdery
+ 
+ @param a is the Point2D you want to hash
+ @return hash of the y component
+ */
+inline std::size_t TreeHash<Point2D,PointOrdery>::operator()(const Point2D& a) const
+{
+    return std::hash<int>()(a.gety());
+}
+
 #endif /* comparators_h */
@@ -0,0 +1,80 @@
+/** @file hash_index_test.cpp
+ @brief Checks that the hash index of a BinarySearchTree stays in step with the tree when values are popped.
+
+ This is its own program, separate from main.cpp. It is built with something like
+    clang++ -std=c++17 -g -O1 -fsanitize=address hash_index_test.cpp -o hash_index_test
+ and exits with 1 after printing what went wrong, or 0 if every check passed. Build it with the sanitizer and some optimisation, so the
+ string accessors are inlined and their reads of a freed node are caught. pop_min and pop_max move the value out of the node they
+ remove, so the node has to leave the index before that happens; with strings a moved-from value hashes differently, and a stale slot
+ would be found again by the lookups below after the node was deleted.
+ */
+
+#include <iostream>
+#include <string>
+#include "BinarySearchTree.h"
+
+
+/** Fills a string tree with the index on, pops from both ends, and looks up every value that was popped and every value that is left.
+
+ @return the number of failed checks
+ */
+int pop_with_index()
+{
+    int failures = 0;
+    BinarySearchTree<std::string> tree;
+    tree.set_hash_index(true);
+    for (int i = 0; i < 100; ++i)
+        tree.insert("value-" + std::to_string(1000 + i));
+
+    for (int i = 0; i < 25; ++i)
+    {
+        std::string low = tree.pop_min();
+        std::string high = tree.pop_max();
+        if (tree.contains(low) || tree.find(low) != tree.end())
+        {
+            std::cout << "pop_min left " << low << " in the index" << std::endl;
+            ++failures;
+        }
+        if (tree.contains(high) || tree.find(high) != tree.end())
+        {
+            std::cout << "pop_max left " << high << " in the index" << std::endl;
+            ++failures;
+        }
+    }
+    for (int i = 25; i < 75; ++i)
+    {
+        std::string value = "value-" + std::to_string(1000 + i);
+        TreeIterator<std::string,std::less<std::string>> it = tree.find(value);
+        if (it == tree.end() || *it != value)
+        {
+            std::cout << "index lost " << value << std::endl;
+            ++failures;
+        }
+    }
+    //values put back after popping go through the index again
+    tree.insert("value-1000");
+    if (!tree.contains("value-1000"))
+    {
+        std::cout << "index missed a value inserted after popping" << std::endl;
+        ++failures;
+    }
+    if (tree.size() != 51)
+    {
+        std::cout << "tree holds " << tree.size() << " values instead of 51" << std::endl;
+        ++failures;
+    }
+    return failures;
+}
+
+
+int main()
+{
+    int failures = pop_with_index();
+    if (failures != 0)
+    {
+        std::cout << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
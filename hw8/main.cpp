@@ -9,6 +9,7 @@
 #include <iostream>
 #include <iterator>
 #include "BinarySearchTree.h"
+#include "BinarySearchMap.h"
 #include "TreeIterator.h"
 #include "TreeNode.h"
 #include "comparators.h"
@@ -114,6 +115,18 @@ int main() {
     names_default_bst = std::move(names_moved_copy);
     
     
+    BinarySearchMap< std::string, int > votes;
+    votes["Luke"] += 2;
+    votes.insert_or_assign( "Kanye", 5 );
+    votes.try_emplace( "Luke", 100 );
+    votes["Pentatonix"] = 1;
+    votes.find("Kanye")->second++;
+    
+    // Prints to the console: Kanye=6,Luke=2,Pentatonix=1,
+    for(auto x : votes)  std::cout << x.first << "=" << x.second << ",";
+    std::cout << std::endl;
+    
+    
     return 0;
 }
 
@@ -0,0 +1,384 @@
+/** @file replay.cpp
+ @brief Replays a trace recorded by RecordingSearchTree against one of the tree variants and reports the latency of each kind of operation.
+
+ This is its own program, separate from main.cpp. It is built with something like
+    clang++ -std=c++17 -O2 -pthread replay.cpp -o replay
+ and run as "replay trace [variant] [threads]". variant is one of bst (the default), lazy, splay, filter, buffered or paged. With more than
+ one thread the keys are split between threads by hash, each thread replaying its share of the operations in their original order against
+ its own tree, so every operation on a key still sees the ones before it. Walks over the tree are replayed by every thread on its own part.
+ The trees use the comparator the trace was recorded with: std::less or std::greater for int, PointOrderx or PointOrdery for Point2D.
+
+ Every operation is timed on its own. The output has one line per kind of operation with its count and its 50th, 99th and 99.9th percentile
+ and largest latency in nanoseconds, taken from a histogram whose buckets are at most 1/16 wider than their lower bound.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "BinarySearchTree.h"
+#include "BufferedSearchTree.h"
+#include "PagedSearchTree.h"
+#include "TreeTrace.h"
+#include "comparators.h"
+#include "Point2D.h"
+
+
+/**@class LatencyHistogram
+	@brief Counts latencies in log-linear buckets: exact below 32 ns, then 16 buckets for every power of two.
+ */
+class LatencyHistogram
+{
+public:
+    //constructor for an empty histogram
+    LatencyHistogram();
+    //count one latency
+    void add(std::uint64_t ns);
+    //add the counts of another histogram
+    void merge(const LatencyHistogram& other);
+    //number of latencies counted
+    std::uint64_t count() const;
+    //lower bound of the bucket holding the given fraction of latencies at or below it
+    std::uint64_t percentile(double fraction) const;
+    //largest latency counted
+    std::uint64_t max() const;
+
+private:
+    //bucket a latency falls in
+    static std::size_t bucket_of(std::uint64_t ns);
+    //smallest latency in a bucket
+    static std::uint64_t bucket_floor(std::size_t bucket);
+    //count of each bucket
+    std::vector<std::uint64_t> buckets;
+    //number of latencies counted
+    std::uint64_t total;
+    //largest latency counted
+    std::uint64_t largest;
+};
+
+
+/** Definition of the constructor
+ */
+LatencyHistogram::LatencyHistogram() : buckets(32 + 59 * 16, 0)
+{
+    total = 0;
+    largest = 0;
+}
+
+
+/** Definition of the add function
+
+ @param ns is the latency in nanoseconds
+ */
+void LatencyHistogram::add(std::uint64_t ns)
+{
+    ++buckets[bucket_of(ns)];
+    ++total;
+    if (ns > largest) largest = ns;
+}
+
+
+/** Definition of the merge function
+
+ @param other is the histogram whose counts are added
+ */
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (std::size_t i = 0; i < buckets.size(); ++i)
+        buckets[i] += other.buckets[i];
+    total += other.total;
+    if (other.largest > largest) largest = other.largest;
+}
+
+
+/** Definition of the count function
+
+ @return the number of latencies counted
+ */
+std::uint64_t LatencyHistogram::count() const
+{
+    return total;
+}
+
+
+/** Definition of the percentile function
+
+ @param fraction is between 0 and 1, 0.99 for the 99th percentile
+ @return the lower bound of the first bucket at which at least that fraction of the latencies are counted
+ */
+std::uint64_t LatencyHistogram::percentile(double fraction) const
+{
+    std::uint64_t wanted = static_cast<std::uint64_t>(fraction * total);
+    if (wanted < 1) wanted = 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i)
+    {
+        seen += buckets[i];
+        if (seen >= wanted) return bucket_floor(i);
+    }
+    return largest;
+}
+
+
+/** Definition of the max function
+
+ @return the largest latency counted
+ */
+std::uint64_t LatencyHistogram::max() const
+{
+    return largest;
+}
+
+
+/** Definition of the bucket_of function. From 32 ns up, the position of the highest set bit picks a power of two and the next four bits
+ pick one of its 16 buckets.
+
+ @param ns is the latency
+ @return its bucket
+ */
+std::size_t LatencyHistogram::bucket_of(std::uint64_t ns)
+{
+    if (ns < 32) return static_cast<std::size_t>(ns);
+    unsigned top = 63;
+    while (!(ns >> top)) --top;
+    return 32 + (top - 5) * 16 + static_cast<std::size_t>((ns >> (top - 4)) & 15);
+}
+
+
+/** Definition of the bucket_floor function
+
+ @param bucket is a bucket index
+ @return the smallest latency that falls in it
+ */
+std::uint64_t LatencyHistogram::bucket_floor(std::size_t bucket)
+{
+    if (bucket < 32) return bucket;
+    std::size_t top = (bucket - 32) / 16 + 5;
+    return static_cast<std::uint64_t>(16 + (bucket - 32) % 16) << (top - 4);
+}
+
+
+/** Looks up a value in one of the BinarySearchTree variants. find is used rather than contains so that splaying is replayed too.
+
+ @param tree is the tree to search
+ @param key is the value looked for
+ @return true if it is in the tree
+ */
+template <typename T,typename CMP>
+bool lookup(BinarySearchTree<T,CMP>& tree, const T& key)
+{
+    return tree.find(key) != tree.end();
+}
+
+
+/** Looks up a value in a variant that has no find, only contains.
+
+ @param tree is the tree to search
+ @param key is the value looked for
+ @return true if it is in the tree
+ */
+template <typename Tree,typename T>
+bool lookup(Tree& tree, const T& key)
+{
+    return tree.contains(key);
+}
+
+
+/** Replays a thread's share of a trace against its tree, timing every operation.
+
+ @param tree is the tree to replay against
+ @param records is the whole trace
+ @param mine holds the indexes of the operations this thread replays
+ @param histograms gets one latency histogram per operation, indexed by TraceOp
+ @return a count of found values and walked values, so the work can't be optimised away
+ */
+template <typename Tree,typename T>
+std::size_t replay_part(Tree& tree, const std::vector<TraceRecord<T>>& records, const std::vector<std::size_t>& mine, std::vector<LatencyHistogram>& histograms)
+{
+    std::size_t seen = 0;
+    for (std::size_t i : mine)
+    {
+        const TraceRecord<T>& record = records[i];
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        switch (record.op)
+        {
+            case TraceOp::insert:
+                tree.insert(record.key);
+                break;
+            case TraceOp::erase:
+                tree.erase(record.key);
+                break;
+            case TraceOp::find:
+                seen += lookup(tree, record.key);
+                break;
+            case TraceOp::iterate:
+                for (auto it = tree.begin(); it != tree.end(); ++it)
+                    ++seen;
+                break;
+        }
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+        histograms[static_cast<std::size_t>(record.op)].add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()));
+    }
+    return seen;
+}
+
+
+/** Builds a thread's tree of the chosen variant and replays its share of the trace against it.
+
+ @param variant is the name of the tree variant
+ @param part is the index of the thread, used to name the file of a paged tree
+ @param records is the whole trace
+ @param mine holds the indexes of the operations this thread replays
+ @param histograms gets one latency histogram per operation
+ @return what replay_part returned
+ @throws std::invalid_argument if the variant is unknown
+ */
+template <typename T,typename CMP>
+std::size_t replay_variant(const std::string& variant, unsigned part, const std::vector<TraceRecord<T>>& records, const std::vector<std::size_t>& mine, std::vector<LatencyHistogram>& histograms)
+{
+    if (variant == "bst" || variant == "lazy" || variant == "splay" || variant == "filter")
+    {
+        BinarySearchTree<T,CMP> tree;
+        if (variant == "lazy") tree.set_lazy_erase(true);
+        if (variant == "splay") tree.set_splay_interval(8);
+        if (variant == "filter") tree.set_filter(true);
+        return replay_part(tree, records, mine, histograms);
+    }
+    if (variant == "buffered")
+    {
+        BufferedSearchTree<T,CMP> tree;
+        return replay_part(tree, records, mine, histograms);
+    }
+    if (variant == "paged")
+    {
+        std::string path = "/tmp/replay-" + std::to_string(::getpid()) + "-" + std::to_string(part) + ".db";
+        std::size_t seen;
+        {
+            PagedSearchTree<T,CMP> tree(path);
+            seen = replay_part(tree, records, mine, histograms);
+        }
+        ::unlink(path.c_str());
+        return seen;
+    }
+    throw std::invalid_argument("unknown variant " + variant);
+}
+
+
+/** Reads a trace, splits it between threads by the hash of each key, replays it and prints the latencies.
+
+ @param path of the trace
+ @param variant is the name of the tree variant
+ @param threads is the number of threads to replay on
+ */
+template <typename T,typename CMP>
+void replay(const std::string& path, const std::string& variant, unsigned threads)
+{
+    std::vector<TraceRecord<T>> records = read_trace<T,CMP>(path);
+    std::vector<std::vector<std::size_t>> parts(threads);
+    TreeHash<T,CMP> hash;
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        if (records[i].op == TraceOp::iterate)
+        {
+            for (std::vector<std::size_t>& part : parts)
+                part.push_back(i);
+            continue;
+        }
+        //mix the hash, since std::hash of an int is often the int itself
+        std::uint64_t h = static_cast<std::uint64_t>(hash(records[i].key)) * 0x9E3779B97F4A7C15ULL;
+        parts[(h >> 32) % threads].push_back(i);
+    }
+
+    std::vector<std::vector<LatencyHistogram>> histograms(threads, std::vector<LatencyHistogram>(5));
+    std::vector<std::size_t> seen(threads, 0);
+    std::vector<std::exception_ptr> errors(threads);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            try
+            {
+                seen[t] = replay_variant<T,CMP>(variant, t, records, parts[t], histograms[t]);
+            }
+            catch (...)
+            {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+    for (std::exception_ptr& error : errors)
+    {
+        if (error) std::rethrow_exception(error);
+    }
+
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::cout << records.size() << " operations on " << threads << " threads against " << variant << " in " << seconds << " s ("
+              << records.size() / seconds << " ops/s)" << std::endl;
+    const char* names[] = {"", "insert", "erase", "find", "iterate"};
+    for (std::size_t op = 1; op <= 4; ++op)
+    {
+        LatencyHistogram total;
+        for (unsigned t = 0; t < threads; ++t)
+            total.merge(histograms[t][op]);
+        if (total.count() == 0) continue;
+        std::cout << names[op] << " " << total.count() << " p50 " << total.percentile(0.5) << " p99 " << total.percentile(0.99)
+                  << " p999 " << total.percentile(0.999) << " max " << total.max() << " ns" << std::endl;
+    }
+    std::size_t found = 0;
+    for (std::size_t s : seen)
+        found += s;
+    std::cout << "found or walked " << found << " values" << std::endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: replay trace [bst|lazy|splay|filter|buffered|paged] [threads]" << std::endl;
+        return 2;
+    }
+    std::string path = argv[1];
+    std::string variant = argc > 2 ? argv[2] : "bst";
+    unsigned threads = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 1;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    try
+    {
+        TraceHeader header = read_trace_header(path);
+        if (header.value_code != TraceValue<int>::code && header.value_code != TraceValue<Point2D>::code)
+        {
+            std::cerr << path << " holds values replay does not know" << std::endl;
+            return 1;
+        }
+        if (header.value_code == TraceValue<int>::code && header.order_code == TraceOrder<std::less<int>>::code)
+            replay<int,std::less<int>>(path, variant, threads);
+        else if (header.value_code == TraceValue<int>::code && header.order_code == TraceOrder<std::greater<int>>::code)
+            replay<int,std::greater<int>>(path, variant, threads);
+        else if (header.value_code == TraceValue<Point2D>::code && header.order_code == TraceOrder<PointOrderx>::code)
+            replay<Point2D,PointOrderx>(path, variant, threads);
+        else if (header.value_code == TraceValue<Point2D>::code && header.order_code == TraceOrder<PointOrdery>::code)
+            replay<Point2D,PointOrdery>(path, variant, threads);
+        else
+        {
+            std::cerr << path << " was recorded with an ordering replay does not know" << std::endl;
+            return 1;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}